@@ -65,10 +65,18 @@ int DvectorPopBack(dvector_t* dvector);
 
 int DvectorResize(dvector_t* dvector, size_t new_capacity);
 /*
-*   @Desc: shrink to size
+*   @Desc: shrink to size, never below the reserved capacity
 *   @Params: pointer to a pre-allocated dvector_t data type
 *   @Return: (0) if success or (1) for failure
 */
 int DvectorShrink(dvector_t* dvector);
 
+/*
+*   @Desc: Grows the capacity to at least @capacity and keeps it there, pops
+*          and shrinks no longer reallocate below it
+*   @Params: pointer to a pre-allocated dvector_t data type, size_t capacity
+*   @Return: (0) if success or (1) for failure
+*/
+int DvectorReserve(dvector_t* dvector, size_t capacity);
+
 #endif  /*End of header guard Dvector*/ 
@@ -104,4 +104,36 @@ int HeapIsEmpty(const heap_t* heap);
 */
 void* HeapRemove(heap_t* heap, void* param, is_match_t is_match);
 
+
+/*
+*	@desc:				Removes every element that matches @is_match with @param
+*						and restores the heap order once, instead of once per
+*						removed element. @is_match may free the elements it
+*						matches
+*	@param:				@heap: preallocated heap
+*						@param: User param to match with
+*						@is_match: match function for checking if element 
+*						matches with @param
+*	@return:			Returns the count of removed elements
+*	@error:				Undefined behavior if @heap is invalid or @is_match is 
+*						invalid
+*	@time complexity:	O(n * is_match) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+size_t HeapRemoveAll(heap_t* heap, void* param, is_match_t is_match);
+
+
+/*
+*	@desc:				Makes room for @capacity elements and keeps it, so
+*						pushes and pops up to @capacity never allocate
+*	@param:				@heap: preallocated heap
+*						@capacity: elements to keep room for
+*	@return:			Zero if function successful otherwise non zero
+*	@error:				Undefined behavior if @heap is invalid
+*						Returns nonzero value if allocation failed
+*	@time complexity:	O(n) for both AC/WC
+*	@space complexity:	O(capacity) for both AC/WC
+*/
+int HeapReserve(heap_t* heap, size_t capacity);
+
 #endif /* __HEAP_H__ */
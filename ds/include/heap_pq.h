@@ -17,6 +17,23 @@ typedef struct priority_queue heap_pq_t;
 */
 heap_pq_t* PQCreate(int (*compare_func)(const void*, const void*));
 
+/* 
+*   @desc:          Allocates Priority Queue backed by a radix heap, for
+*					unsigned keys that mostly move forward, like deadlines.
+*					Enqueue is O(1) and dequeue O(log C) amortized, C being
+*					the key range. Enqueueing a key below the last dequeued
+*					one is allowed but costs O(n)
+*   @params: 		@key_func: returns the key of an element, the lowest key
+*					comes out first. It mustn't change while the element is
+*					queued
+*   @return value:  Pointer to the allocated Priority Queue
+*   @error: 		NULL if allocation fails
+*					Undefined behavior if @key_func is not valid
+*   @time complex: 	O(malloc) for both AC/WC
+*   @space complex: O(malloc) for both AC/WC
+*/
+heap_pq_t* PQCreateRadix(unsigned long (*key_func)(const void*));
+
 /* 
 *   @desc: 	        Frees Priority Queue. Must be created using @PQCreate.		
 *   @params: 	    @pq: Priority queue to free.
@@ -101,4 +118,29 @@ void PQClear(heap_pq_t* pq);
 */
 void* PQErase(heap_pq_t* pq, int (*is_match)(const void*, const void*), const void* param);
 
+
+/*
+*   @desc:          Removes every element matching @param in @is_match param.
+*					@is_match may free the elements it matches
+*   @params:        @pq : pre allocated priority queue.
+*	@return value:	The count of erased elements
+*	@error:			Undefined behavior if @is_match or @pq is invalid                     
+*	@time complex:	O(n) for both AC/WC.
+*	@space complex:	O(1) for both AC/WC.
+*/
+size_t PQEraseAll(heap_pq_t* pq, int (*is_match)(const void*, const void*),
+                                                            const void* param);
+
+/*
+*   @desc:          Makes room for @capacity elements up front, so enqueues
+*					and dequeues up to @capacity never allocate
+*   @params:        @pq : pre allocated priority queue.
+*					@capacity : elements to keep room for
+*	@return value:	zero on success and nonzero if allocation failed
+*	@error:			Undefined behavior if @pq is invalid
+*	@time complex:	O(n) for both AC/WC.
+*	@space complex:	O(capacity) for both AC/WC.
+*/
+int PQReserve(heap_pq_t* pq, size_t capacity);
+
 #endif  /* __PQ_HEAP_H__ */
@@ -0,0 +1,104 @@
+#ifndef __MULTI_PQ_H__
+#define __MULTI_PQ_H__
+
+#include <stddef.h> /* size_t */
+
+/*
+*	Relaxed concurrent priority queue of unsigned long keys, for several
+*	threads enqueueing and dequeueing at once. It is a MultiQueue: a set of
+*	heaps, each behind its own lock. An enqueue takes any heap whose lock is
+*	free, a dequeue compares the tops of two random heaps and pops the lower
+*	one. No thread ever waits on a held lock, it picks other heaps instead.
+*	The price is the order: a dequeue returns one of the lowest keys, not
+*	always the lowest, and a single thread sees the exact order only with
+*	one heap. Use about twice as many heaps as threads.
+*/
+
+typedef struct multi_pq multi_pq_t;
+typedef unsigned long (*mpq_key_t)(const void* data);
+
+
+/*
+*	@desc:				Allocates new queue of @queues heaps ordered by @key_func
+*	@param:				@queues: count of heaps, at least 1
+*						@key_func: returns the key of an element. The key of an
+*						element mustn't change while it is in the queue
+*	@return:			Newly allocated queue
+*	@error:				Returns NULL if allocation failed
+*	@time complexity:	O(queues) for both AC/WC
+*	@space complexity:	O(queues) for both AC/WC
+*/
+multi_pq_t* MPQCreate(size_t queues, mpq_key_t key_func);
+
+
+/*
+*	@desc:				Frees @pq, no thread may use it anymore
+*	@param:				@pq: queue created by @MPQCreate
+*	@return:			None
+*	@error:				Undefined behavior if @pq is invalid
+*	@time complexity:	O(queues) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void MPQDestroy(multi_pq_t* pq);
+
+
+/*
+*	@desc:				Enqueues @data to @pq, safe from any thread
+*	@param:				@pq: preallocated queue
+*						@data: user data to insert
+*	@return:			Zero if function successful otherwise non zero
+*	@error:				Undefined behavior if @pq is invalid
+*						Returns nonzero value if allocation failed
+*	@time complexity:	O(log n) AC, O(n) WC when a heap grows
+*	@space complexity:	O(1) for AC and O(n) for WC
+*/
+int MPQEnqueue(multi_pq_t* pq, void* data);
+
+
+/*
+*	@desc:				Dequeues one of the lowest keyed elements of @pq, safe
+*						from any thread
+*	@param:				@pq: preallocated queue
+*	@return:			The dequeued data, NULL if @pq was empty
+*	@error:				Undefined behavior if @pq is invalid
+*	@time complexity:	O(log n) AC, O(queues + log n) WC when @pq is almost
+*						empty
+*	@space complexity:	O(1) for both AC/WC
+*/
+void* MPQDequeue(multi_pq_t* pq);
+
+
+/*
+*	@desc:				Removes the first element of @pq that @is_match matches
+*						with @param, safe from any thread
+*	@param:				@pq: preallocated queue
+*						@is_match: returns nonzero for a matching element
+*						@param: user param passed to @is_match
+*	@return:			The data of the erased element, NULL if none matched
+*	@error:				Undefined behavior if @pq or @is_match is invalid
+*	@time complexity:	O(n) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void* MPQErase(multi_pq_t* pq, int (*is_match)(const void*, const void*),
+                                                            const void* param);
+
+
+/*
+*	@desc:				Returns the count of elements in @pq, only exact while
+*						no other thread changes it
+*	@param:				@pq: preallocated queue
+*	@return:			Count of elements
+*	@error:				Undefined behavior if @pq is invalid
+*	@time complexity:	O(queues) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+size_t MPQSize(const multi_pq_t* pq);
+
+
+/*
+*	@desc:				Returns nonzero if @pq is empty, with the same caveat
+*						as @MPQSize
+*/
+int MPQIsEmpty(const multi_pq_t* pq);
+
+#endif /* __MULTI_PQ_H__ */
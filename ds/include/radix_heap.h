@@ -0,0 +1,132 @@
+#ifndef __RADIX_HEAP_H__
+#define __RADIX_HEAP_H__
+
+#include <stddef.h> /* size_t */
+
+#include "heap.h"   /* is_match_t */
+
+/*
+*	Min heap of unsigned long keys, made for keys that only move forward,
+*	like deadlines. Elements sit in buckets by the highest bit their key
+*	differs from the last popped key. A push is O(1), a pop moves the
+*	elements of one bucket down, so every element moves at most once per
+*	key bit. A key below the last popped one is still accepted, it rebuilds
+*	the buckets in O(n).
+*/
+
+typedef struct radix_heap radix_heap_t;
+typedef unsigned long (*radix_key_t)(const void* data);
+
+
+/*
+*	@desc:				Allocates new radix heap ordered by @key_func
+*	@param:				@key_func: returns the key of an element. The key of an
+*						element mustn't change while it is in the heap
+*	@return:			Newly allocated radix heap
+*	@error:				Returns NULL if allocation failed
+*	@time complexity:	O(malloc) for both AC/WC
+*	@space complexity:	O(malloc) for both AC/WC
+*/
+radix_heap_t* RadixCreate(radix_key_t key_func);
+
+
+/*
+*	@desc:				Frees @heap
+*	@param:				@heap: heap created by @RadixCreate
+*	@return:			None
+*	@error:				Undefined behavior if @heap is invalid
+*	@time complexity:	O(free) for both AC/WC
+*	@space complexity:	O(free) for both AC/WC
+*/
+void RadixDestroy(radix_heap_t* heap);
+
+
+/*
+*	@desc:				Pushes @data to @heap
+*	@param:				@heap: preallocated heap
+*						@data: user data to insert
+*	@return:			Zero if function successful otherwise non zero
+*	@error:				Undefined behavior if @heap is invalid
+*						Returns nonzero value if allocation failed
+*	@time complexity:	O(1) AC, O(n) WC for a key below the last popped key
+*	@space complexity:	O(1) for AC and O(n) for WC
+*/
+int RadixPush(radix_heap_t* heap, void* data);
+
+
+/*
+*	@desc:				Pops the element with the lowest key from @heap
+*	@param:				@heap: preallocated heap
+*	@return:			Zero
+*	@error:				Undefined behavior if @heap is invalid or @heap is empty
+*	@time complexity:	O(log C) amortized, C being the key range
+*	@space complexity:	O(1) for both AC/WC
+*/
+int RadixPop(radix_heap_t* heap);
+
+
+/*
+*	@desc:				Returns the element with the lowest key in @heap
+*	@param:				@heap: preallocated heap
+*	@return:			Its data
+*	@error:				Undefined behavior if @heap is invalid or @heap is empty
+*	@time complexity:	O(1) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void* RadixPeek(const radix_heap_t* heap);
+
+
+/*
+*	@desc:				Returns the count of elements in @heap
+*/
+size_t RadixSize(const radix_heap_t* heap);
+
+
+/*
+*	@desc:				Returns one if @heap is empty otherwise zero
+*/
+int RadixIsEmpty(const radix_heap_t* heap);
+
+
+/*
+*	@desc:				Removes the first element matches @is_match with @param
+*	@param:				@heap: preallocated heap
+*						@param: User param to match with
+*						@is_match: match function
+*	@return:			Returns the removed element or NULL if not found
+*	@error:				Undefined behavior if @heap or @is_match is invalid
+*	@time complexity:	O(n * is_match) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void* RadixRemove(radix_heap_t* heap, void* param, is_match_t is_match);
+
+
+/*
+*	@desc:				Removes every element that matches @is_match with
+*						@param. @is_match may free the elements it matches
+*	@param:				@heap: preallocated heap
+*						@param: User param to match with
+*						@is_match: match function
+*	@return:			Returns the count of removed elements
+*	@error:				Undefined behavior if @heap or @is_match is invalid
+*	@time complexity:	O(n * is_match) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+size_t RadixRemoveAll(radix_heap_t* heap, void* param, is_match_t is_match);
+
+
+/*
+*	@desc:				Makes room for @capacity elements in every bucket, so
+*						pushes, pops and redistributions up to @capacity
+*						never allocate. Buckets never shrink
+*	@param:				@heap: preallocated heap
+*						@capacity: elements to keep room for
+*	@return:			Zero if function successful otherwise non zero
+*	@error:				Undefined behavior if @heap is invalid
+*						Returns nonzero value if allocation failed
+*	@time complexity:	O(n) for both AC/WC
+*	@space complexity:	O(capacity * key bits) for both AC/WC
+*/
+int RadixReserve(radix_heap_t* heap, size_t capacity);
+
+#endif /* __RADIX_HEAP_H__ */
@@ -0,0 +1,322 @@
+#ifndef __TYPED_DS_H__
+#define __TYPED_DS_H__
+
+#include <stddef.h>     /* size_t */
+#include <stdlib.h>     /* malloc, realloc, free */
+#include <assert.h>     /* assert */
+
+/*
+*   Type specialized versions of dvector, heap and heap_pq. Each DEFINE_*
+*   macro generates a struct and its functions for one element type, so
+*   elements are copied by assignment instead of memcpy of element_size bytes
+*   and the heap comparator is expanded in place instead of being called
+*   through a function pointer on every sift step.
+*
+*   DEFINE_VECTOR(Name, T)          Name_t, NameInit, NamePushBack, ...
+*   DEFINE_HEAP(Name, T, LESS)      Name_t, NamePush, NamePop, ...
+*   DEFINE_PQ(Name, T, LESS)        Name_t, NameEnqueue, NameDequeue, ...
+*
+*   @LESS(a, b) is a macro or function returning nonzero if the element @a
+*   comes out before @b. Define each container once per translation unit.
+*/
+
+#define TYPED_INLINE static __inline__
+#define TYPED_INC_FACTOR(x) ((x) + (x) / 2 + 1)
+
+/********************************Vector****************************************/
+
+#define DEFINE_VECTOR(Name, T)                                                 \
+                                                                               \
+typedef struct Name                                                            \
+{                                                                              \
+    T* array;                                                                  \
+    size_t size;                                                               \
+    size_t capacity;                                                           \
+} Name##_t;                                                                    \
+                                                                               \
+TYPED_INLINE int Name##Init(Name##_t* vector, size_t capacity)                 \
+{                                                                              \
+    assert(vector);                                                            \
+                                                                               \
+    vector->size = 0;                                                          \
+    vector->capacity = capacity ? capacity : 1;                                \
+    vector->array = (T*)malloc(vector->capacity * sizeof(T));                  \
+                                                                               \
+    return vector->array ? 0 : 1;                                              \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##Destroy(Name##_t* vector)                              \
+{                                                                              \
+    assert(vector);                                                            \
+                                                                               \
+    free(vector->array);                                                       \
+    vector->array = NULL;                                                      \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##Reserve(Name##_t* vector, size_t capacity)              \
+{                                                                              \
+    T* array = NULL;                                                           \
+                                                                               \
+    assert(vector);                                                            \
+                                                                               \
+    if(capacity <= vector->capacity)                                           \
+    {                                                                          \
+        return 0;                                                              \
+    }                                                                          \
+                                                                               \
+    array = (T*)realloc(vector->array, capacity * sizeof(T));                  \
+                                                                               \
+    if(!array)                                                                 \
+    {                                                                          \
+        return 1;                                                              \
+    }                                                                          \
+                                                                               \
+    vector->array = array;                                                     \
+    vector->capacity = capacity;                                               \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##PushBack(Name##_t* vector, T element)                   \
+{                                                                              \
+    if(vector->size == vector->capacity &&                                     \
+            Name##Reserve(vector, TYPED_INC_FACTOR(vector->capacity)))         \
+    {                                                                          \
+        return 1;                                                              \
+    }                                                                          \
+                                                                               \
+    vector->array[vector->size++] = element;                                   \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##PopBack(Name##_t* vector)                               \
+{                                                                              \
+    if(!vector->size)                                                          \
+    {                                                                          \
+        return 1;                                                              \
+    }                                                                          \
+                                                                               \
+    --vector->size;                                                            \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE T* Name##At(const Name##_t* vector, size_t index)                 \
+{                                                                              \
+    assert(index < vector->size);                                              \
+                                                                               \
+    return vector->array + index;                                              \
+}                                                                              \
+                                                                               \
+TYPED_INLINE size_t Name##Size(const Name##_t* vector)                         \
+{                                                                              \
+    return vector->size;                                                       \
+}                                                                              \
+                                                                               \
+TYPED_INLINE size_t Name##Capacity(const Name##_t* vector)                     \
+{                                                                              \
+    return vector->capacity;                                                   \
+}
+
+/*********************************Heap*****************************************/
+
+#define DEFINE_HEAP(Name, T, LESS)                                             \
+                                                                               \
+DEFINE_VECTOR(Name##Vector, T)                                                 \
+                                                                               \
+typedef struct Name                                                            \
+{                                                                              \
+    Name##Vector_t vector;                                                     \
+} Name##_t;                                                                    \
+                                                                               \
+TYPED_INLINE int Name##Init(Name##_t* heap, size_t capacity)                   \
+{                                                                              \
+    return Name##VectorInit(&heap->vector, capacity);                          \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##Destroy(Name##_t* heap)                                \
+{                                                                              \
+    Name##VectorDestroy(&heap->vector);                                        \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##SiftUp(Name##_t* heap, size_t index)                   \
+{                                                                              \
+    T* array = heap->vector.array;                                             \
+    T element = array[index];                                                  \
+    size_t parent = 0;                                                         \
+                                                                               \
+    while(index > 0)                                                           \
+    {                                                                          \
+        parent = (index - 1) / 2;                                              \
+                                                                               \
+        if(!(LESS(element, array[parent])))                                    \
+        {                                                                      \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        array[index] = array[parent];                                          \
+        index = parent;                                                        \
+    }                                                                          \
+                                                                               \
+    array[index] = element;                                                    \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##SiftDown(Name##_t* heap, size_t index)                 \
+{                                                                              \
+    T* array = heap->vector.array;                                             \
+    size_t size = heap->vector.size;                                           \
+    T element = array[index];                                                  \
+    size_t child = 0;                                                          \
+                                                                               \
+    while((child = index * 2 + 1) < size)                                      \
+    {                                                                          \
+        if(child + 1 < size && LESS(array[child + 1], array[child]))           \
+        {                                                                      \
+            ++child;                                                           \
+        }                                                                      \
+                                                                               \
+        if(!(LESS(array[child], element)))                                     \
+        {                                                                      \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        array[index] = array[child];                                           \
+        index = child;                                                         \
+    }                                                                          \
+                                                                               \
+    array[index] = element;                                                    \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##Push(Name##_t* heap, T data)                            \
+{                                                                              \
+    if(Name##VectorPushBack(&heap->vector, data))                              \
+    {                                                                          \
+        return 1;                                                              \
+    }                                                                          \
+                                                                               \
+    Name##SiftUp(heap, heap->vector.size - 1);                                 \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE T Name##Pop(Name##_t* heap)                                       \
+{                                                                              \
+    T* array = heap->vector.array;                                             \
+    T top = array[0];                                                          \
+                                                                               \
+    assert(heap->vector.size);                                                 \
+                                                                               \
+    array[0] = array[--heap->vector.size];                                     \
+                                                                               \
+    if(heap->vector.size)                                                      \
+    {                                                                          \
+        Name##SiftDown(heap, 0);                                               \
+    }                                                                          \
+                                                                               \
+    return top;                                                                \
+}                                                                              \
+                                                                               \
+TYPED_INLINE T* Name##Peek(const Name##_t* heap)                               \
+{                                                                              \
+    assert(heap->vector.size);                                                 \
+                                                                               \
+    return heap->vector.array;                                                 \
+}                                                                              \
+                                                                               \
+TYPED_INLINE size_t Name##Size(const Name##_t* heap)                           \
+{                                                                              \
+    return heap->vector.size;                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##IsEmpty(const Name##_t* heap)                           \
+{                                                                              \
+    return 0 == heap->vector.size;                                             \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##Remove(Name##_t* heap,                                  \
+                int (*is_match)(const T*, const void*), const void* param,    \
+                                                                    T* out)    \
+{                                                                              \
+    T* array = heap->vector.array;                                             \
+    size_t i = 0;                                                              \
+                                                                               \
+    for(; i < heap->vector.size; ++i)                                          \
+    {                                                                          \
+        if(is_match((const T*)(array + i), param))                             \
+        {                                                                      \
+            *out = array[i];                                                   \
+            array[i] = array[--heap->vector.size];                             \
+                                                                               \
+            if(i < heap->vector.size)                                          \
+            {                                                                  \
+                Name##SiftDown(heap, i);                                       \
+                Name##SiftUp(heap, i);                                         \
+            }                                                                  \
+                                                                               \
+            return 0;                                                          \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    return 1;                                                                  \
+}
+
+/****************************Priority Queue************************************/
+
+#define DEFINE_PQ(Name, T, LESS)                                               \
+                                                                               \
+DEFINE_HEAP(Name##Heap, T, LESS)                                               \
+                                                                               \
+typedef struct Name                                                            \
+{                                                                              \
+    Name##Heap_t heap;                                                         \
+} Name##_t;                                                                    \
+                                                                               \
+TYPED_INLINE int Name##Create(Name##_t* pq, size_t capacity)                   \
+{                                                                              \
+    return Name##HeapInit(&pq->heap, capacity);                                \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##Destroy(Name##_t* pq)                                  \
+{                                                                              \
+    Name##HeapDestroy(&pq->heap);                                              \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##Enqueue(Name##_t* pq, T data)                           \
+{                                                                              \
+    return Name##HeapPush(&pq->heap, data);                                    \
+}                                                                              \
+                                                                               \
+TYPED_INLINE T Name##Dequeue(Name##_t* pq)                                     \
+{                                                                              \
+    return Name##HeapPop(&pq->heap);                                           \
+}                                                                              \
+                                                                               \
+TYPED_INLINE T* Name##Peek(const Name##_t* pq)                                 \
+{                                                                              \
+    return Name##HeapPeek(&pq->heap);                                          \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##IsEmpty(const Name##_t* pq)                             \
+{                                                                              \
+    return Name##HeapIsEmpty(&pq->heap);                                       \
+}                                                                              \
+                                                                               \
+TYPED_INLINE size_t Name##Size(const Name##_t* pq)                             \
+{                                                                              \
+    return Name##HeapSize(&pq->heap);                                          \
+}                                                                              \
+                                                                               \
+TYPED_INLINE void Name##Clear(Name##_t* pq)                                    \
+{                                                                              \
+    pq->heap.vector.size = 0;                                                  \
+}                                                                              \
+                                                                               \
+TYPED_INLINE int Name##Erase(Name##_t* pq,                                     \
+                int (*is_match)(const T*, const void*), const void* param,    \
+                                                                    T* out)    \
+{                                                                              \
+    return Name##HeapRemove(&pq->heap, is_match, param, out);                  \
+}
+
+#endif /* __TYPED_DS_H__ */
@@ -13,6 +13,7 @@ struct dvector {
     size_t size;
     size_t capacity;
     size_t element_size;
+    size_t reserved;
     void* array;
 };
 
@@ -29,6 +30,7 @@ dvector_t* DvectorCreate(size_t capacity, size_t element_size)
     p_dvector->size = 0;
     p_dvector->capacity = capacity;
     p_dvector->element_size = element_size;
+    p_dvector->reserved = 0;
 
     return p_dvector;
 }
@@ -108,7 +110,8 @@ int DvectorPopBack(dvector_t* dvector)
 
     dvector->size--;
 
-    if (dvector->size <= DEC_FACTOR(dvector->capacity))
+    if (dvector->size <= DEC_FACTOR(dvector->capacity) &&
+                                        dvector->capacity > dvector->reserved)
     {
         DvectorShrink(dvector);
     }
@@ -135,5 +138,21 @@ int DvectorResize(dvector_t* dvector, size_t new_capacity)
 
 int DvectorShrink(dvector_t* dvector)
 {
-    return DvectorResize(dvector, dvector->size);
+    return DvectorResize(dvector, dvector->size > dvector->reserved ?
+                                            dvector->size : dvector->reserved);
+}
+
+int DvectorReserve(dvector_t* dvector, size_t capacity)
+{
+    assert(NULL != dvector);
+
+    if (capacity > dvector->capacity &&
+                                FAILURE == DvectorResize(dvector, capacity))
+    {
+        return FAILURE;
+    }
+
+    dvector->reserved = dvector->capacity;
+
+    return SUCCESS;
 }
@@ -219,3 +219,44 @@ void* HeapPeek(const heap_t* heap)
     return dst;
 }
 
+size_t HeapRemoveAll(heap_t* heap, void* param, is_match_t is_match)
+{
+    void* data = NULL;
+    size_t size = 0;
+    size_t kept = 0;
+    size_t i = 0;
+
+    assert(heap);
+    assert(is_match);
+
+    size = DvectorSize(heap->vector);
+
+    for(; i < size; ++i)
+    {
+        DvectorGetElement(heap->vector, i, &data);
+
+        if(!is_match(data, param))
+        {
+            DvectorSetElement(heap->vector, kept++, &data);
+        }
+    }
+
+    for(i = kept; i < size; ++i)
+    {
+        DvectorPopBack(heap->vector);
+    }
+
+    for(i = kept / 2; i > 0; --i)
+    {
+        HeapifyDown(heap, i - 1);
+    }
+
+    return size - kept;
+}
+
+int HeapReserve(heap_t* heap, size_t capacity)
+{
+    assert(heap);
+
+    return DvectorReserve(heap->vector, capacity);
+}
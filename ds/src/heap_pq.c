@@ -3,10 +3,13 @@
 
 #include "heap_pq.h"
 #include "heap.h"
+#include "radix_heap.h"
 
+/* exactly one of the backends is set */
 struct priority_queue
 {
     heap_t* heap;
+    radix_heap_t* radix;
 };
 
 heap_pq_t* PQCreate(int (*compare_func)(const void*, const void*))
@@ -23,6 +26,7 @@ heap_pq_t* PQCreate(int (*compare_func)(const void*, const void*))
     }
     
     pq->heap = HeapCreate(compare_func);
+    pq->radix = NULL;
 
     if (pq->heap == NULL)
     {
@@ -33,11 +37,43 @@ heap_pq_t* PQCreate(int (*compare_func)(const void*, const void*))
     return pq;
 }
 
+heap_pq_t* PQCreateRadix(unsigned long (*key_func)(const void*))
+{
+    heap_pq_t* pq = NULL;
+
+    assert(key_func);
+
+    pq = (heap_pq_t*)malloc(sizeof(heap_pq_t));
+
+    if (pq == NULL)
+    {
+        return NULL;
+    }
+
+    pq->heap = NULL;
+    pq->radix = RadixCreate(key_func);
+
+    if (pq->radix == NULL)
+    {
+        free(pq);
+        return NULL;
+    }
+
+    return pq;
+}
+
 void PQDestroy(heap_pq_t* pq)
 {
     assert(pq);
     
-    HeapDestroy(pq->heap);
+    if (pq->radix)
+    {
+        RadixDestroy(pq->radix);
+    }
+    else
+    {
+        HeapDestroy(pq->heap);
+    }
     free(pq);
 }
 
@@ -45,7 +81,7 @@ int PQEnqueue(heap_pq_t* pq, void* data)
 {
     assert(pq);
     
-    return HeapPush(pq->heap, data);
+    return pq->radix ? RadixPush(pq->radix, data) : HeapPush(pq->heap, data);
 }
 
 void* PQDequeue(heap_pq_t* pq)
@@ -55,6 +91,14 @@ void* PQDequeue(heap_pq_t* pq)
     assert(pq);
     assert(!PQIsEmpty(pq));
     
+    if (pq->radix)
+    {
+        peek = RadixPeek(pq->radix);
+        RadixPop(pq->radix);
+
+        return peek;
+    }
+
     peek = HeapPeek(pq->heap);
     HeapPop(pq->heap);
     
@@ -66,21 +110,21 @@ void* PQPeek(const heap_pq_t* pq)
     assert(pq);
     assert(!PQIsEmpty(pq));
     
-    return HeapPeek(pq->heap);
+    return pq->radix ? RadixPeek(pq->radix) : HeapPeek(pq->heap);
 }
 
 int PQIsEmpty(const heap_pq_t* pq)
 {
     assert(pq);
     
-    return HeapIsEmpty(pq->heap);
+    return pq->radix ? RadixIsEmpty(pq->radix) : HeapIsEmpty(pq->heap);
 }
 
 size_t PQSize(const heap_pq_t* pq)
 {
     assert(pq);
     
-    return HeapSize(pq->heap);
+    return pq->radix ? RadixSize(pq->radix) : HeapSize(pq->heap);
 }
 
 void PQClear(heap_pq_t* pq)
@@ -99,5 +143,24 @@ void* PQErase(heap_pq_t* pq, int (*is_match)(const void*, const void*),
     assert(pq);
     assert(is_match);
 
-    return HeapRemove(pq->heap, (void*)param, is_match);
+    return pq->radix ? RadixRemove(pq->radix, (void*)param, is_match) :
+                                HeapRemove(pq->heap, (void*)param, is_match);
+}
+
+size_t PQEraseAll(heap_pq_t* pq, int (*is_match)(const void*, const void*),
+                                                            const void* param)
+{
+    assert(pq);
+    assert(is_match);
+
+    return pq->radix ? RadixRemoveAll(pq->radix, (void*)param, is_match) :
+                            HeapRemoveAll(pq->heap, (void*)param, is_match);
+}
+
+int PQReserve(heap_pq_t* pq, size_t capacity)
+{
+    assert(pq);
+
+    return pq->radix ? RadixReserve(pq->radix, capacity) :
+                                        HeapReserve(pq->heap, capacity);
 }
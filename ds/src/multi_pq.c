@@ -0,0 +1,324 @@
+#include <stdlib.h>     /* malloc, free */
+#include <assert.h>     /* assert */
+#include <pthread.h>    /* pthread_mutex_t, pthread_mutex_trylock */
+#include <stdatomic.h>  /* atomic_ulong, atomic_size_t */
+
+#include "multi_pq.h"
+#include "typed_ds.h"
+
+#define HEAP_CAPACITY (16)
+#define CACHE_LINE (64)
+#define EMPTY_KEY ((unsigned long)-1)
+#define TRIES_PER_QUEUE (4)
+
+typedef struct mpq_entry
+{
+    unsigned long key;
+    void* data;
+} mpq_entry_t;
+
+#define ENTRY_LESS(a, b) ((a).key < (b).key)
+
+DEFINE_PQ(EntryPQ, mpq_entry_t, ENTRY_LESS)
+
+/*
+*   @top and @size mirror the heap so other threads can pick a heap without
+*   its lock. The padding keeps the hot fields of neighbours on separate
+*   cache lines
+*/
+typedef struct sub_queue
+{
+    pthread_mutex_t lock;
+    EntryPQ_t heap;
+    atomic_ulong top;
+    atomic_size_t size;
+    char pad[CACHE_LINE];
+} sub_queue_t;
+
+struct multi_pq
+{
+    sub_queue_t* queues;
+    size_t count;
+    mpq_key_t key_func;
+};
+
+typedef struct match
+{
+    int (*is_match)(const void*, const void*);
+    const void* param;
+} match_t;
+
+/**********************Static Functions Implementation*************************/
+
+/* xorshift, each thread has its own state when the compiler allows it */
+static unsigned long NextRandom(void)
+{
+#ifdef __GNUC__
+    static __thread unsigned long state;
+
+    if(!state)
+    {
+        state = (unsigned long)&state | 1;
+    }
+#else
+    static atomic_ulong shared = 1;
+    unsigned long state = atomic_fetch_add(&shared, 0x9E3779B9UL);
+#endif
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    return state;
+}
+
+static sub_queue_t* Pick(const multi_pq_t* pq)
+{
+    return pq->queues + (NextRandom() >> 8) % pq->count;
+}
+
+static void Publish(sub_queue_t* queue)
+{
+    size_t size = EntryPQSize(&queue->heap);
+
+    atomic_store_explicit(&queue->size, size, memory_order_relaxed);
+    atomic_store_explicit(&queue->top, size ? EntryPQPeek(&queue->heap)->key :
+                                            EMPTY_KEY, memory_order_relaxed);
+}
+
+/* the caller holds the lock of @queue */
+static void* PopLocked(sub_queue_t* queue)
+{
+    void* data = NULL;
+
+    if(!EntryPQIsEmpty(&queue->heap))
+    {
+        data = EntryPQDequeue(&queue->heap).data;
+        Publish(queue);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return data;
+}
+
+static int IsEmptyQueue(const sub_queue_t* queue)
+{
+    return !atomic_load_explicit(&((sub_queue_t*)queue)->size,
+                                                    memory_order_relaxed);
+}
+
+/* the lower of two random tops, an empty heap never wins */
+static sub_queue_t* PickLower(const multi_pq_t* pq)
+{
+    sub_queue_t* one = Pick(pq);
+    sub_queue_t* other = Pick(pq);
+
+    if(IsEmptyQueue(one) || (!IsEmptyQueue(other) &&
+            atomic_load_explicit(&other->top, memory_order_relaxed) <
+            atomic_load_explicit(&one->top, memory_order_relaxed)))
+    {
+        return other;
+    }
+
+    return one;
+}
+
+static int MatchEntry(const mpq_entry_t* entry, const void* param)
+{
+    const match_t* match = (const match_t*)param;
+
+    return match->is_match(entry->data, match->param);
+}
+
+/*****************************API Functions************************************/
+
+multi_pq_t* MPQCreate(size_t queues, mpq_key_t key_func)
+{
+    multi_pq_t* pq = NULL;
+    size_t i = 0;
+
+    assert(queues);
+    assert(key_func);
+
+    pq = (multi_pq_t*)malloc(sizeof(multi_pq_t));
+    if(!pq)
+    {
+        return NULL;
+    }
+
+    pq->queues = (sub_queue_t*)malloc(queues * sizeof(sub_queue_t));
+    if(!pq->queues)
+    {
+        free(pq);
+        return NULL;
+    }
+
+    for(; i < queues; ++i)
+    {
+        if(EntryPQCreate(&pq->queues[i].heap, HEAP_CAPACITY))
+        {
+            while(i--)
+            {
+                pthread_mutex_destroy(&pq->queues[i].lock);
+                EntryPQDestroy(&pq->queues[i].heap);
+            }
+
+            free(pq->queues);
+            free(pq);
+            return NULL;
+        }
+
+        pthread_mutex_init(&pq->queues[i].lock, NULL);
+        atomic_init(&pq->queues[i].top, EMPTY_KEY);
+        atomic_init(&pq->queues[i].size, 0);
+    }
+
+    pq->count = queues;
+    pq->key_func = key_func;
+
+    return pq;
+}
+
+void MPQDestroy(multi_pq_t* pq)
+{
+    size_t i = 0;
+
+    assert(pq);
+
+    for(; i < pq->count; ++i)
+    {
+        pthread_mutex_destroy(&pq->queues[i].lock);
+        EntryPQDestroy(&pq->queues[i].heap);
+    }
+
+    free(pq->queues);
+    free(pq);
+}
+
+int MPQEnqueue(multi_pq_t* pq, void* data)
+{
+    sub_queue_t* queue = NULL;
+    mpq_entry_t entry;
+    size_t tries = 0;
+    int status = 0;
+
+    assert(pq);
+
+    entry.key = pq->key_func(data);
+    entry.data = data;
+
+    /* only wait for a lock after every heap seemed busy */
+    do
+    {
+        queue = Pick(pq);
+    } while(pthread_mutex_trylock(&queue->lock) &&
+                                        ++tries < pq->count * TRIES_PER_QUEUE);
+
+    if(tries == pq->count * TRIES_PER_QUEUE)
+    {
+        pthread_mutex_lock(&queue->lock);
+    }
+
+    status = EntryPQEnqueue(&queue->heap, entry);
+    Publish(queue);
+    pthread_mutex_unlock(&queue->lock);
+
+    return status;
+}
+
+void* MPQDequeue(multi_pq_t* pq)
+{
+    sub_queue_t* queue = NULL;
+    void* data = NULL;
+    size_t tries = 0;
+    size_t i = 0;
+
+    assert(pq);
+
+    for(; tries < pq->count * TRIES_PER_QUEUE; ++tries)
+    {
+        queue = PickLower(pq);
+
+        if(!IsEmptyQueue(queue) && !pthread_mutex_trylock(&queue->lock) &&
+                                            (data = PopLocked(queue)))
+        {
+            return data;
+        }
+    }
+
+    /* mostly empty, look at every heap before reporting it empty */
+    for(; i < pq->count; ++i)
+    {
+        queue = pq->queues + i;
+
+        if(!IsEmptyQueue(queue))
+        {
+            pthread_mutex_lock(&queue->lock);
+
+            if((data = PopLocked(queue)))
+            {
+                return data;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+void* MPQErase(multi_pq_t* pq, int (*is_match)(const void*, const void*),
+                                                            const void* param)
+{
+    mpq_entry_t entry;
+    match_t match;
+    size_t i = 0;
+    int missed = 1;
+
+    assert(pq);
+    assert(is_match);
+
+    match.is_match = is_match;
+    match.param = param;
+
+    for(; missed && i < pq->count; ++i)
+    {
+        sub_queue_t* queue = pq->queues + i;
+
+        pthread_mutex_lock(&queue->lock);
+        missed = EntryPQErase(&queue->heap, MatchEntry, &match, &entry);
+        Publish(queue);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    return missed ? NULL : entry.data;
+}
+
+size_t MPQSize(const multi_pq_t* pq)
+{
+    size_t size = 0;
+    size_t i = 0;
+
+    assert(pq);
+
+    for(; i < pq->count; ++i)
+    {
+        size += atomic_load_explicit(&pq->queues[i].size,
+                                                    memory_order_relaxed);
+    }
+
+    return size;
+}
+
+int MPQIsEmpty(const multi_pq_t* pq)
+{
+    size_t i = 0;
+
+    assert(pq);
+
+    while(i < pq->count && IsEmptyQueue(pq->queues + i))
+    {
+        ++i;
+    }
+
+    return i == pq->count;
+}
@@ -0,0 +1,393 @@
+#include <stdlib.h>     /* malloc, free */
+#include <limits.h>     /* CHAR_BIT */
+#include <assert.h>     /* assert */
+
+#include "radix_heap.h"
+#include "typed_ds.h"
+
+#define KEY_BITS (CHAR_BIT * sizeof(unsigned long))
+#define BUCKETS (KEY_BITS + 1)
+#define BUCKET_CAPACITY (4)
+
+typedef struct radix_entry
+{
+    unsigned long key;
+    void* data;
+} radix_entry_t;
+
+DEFINE_VECTOR(Bucket, radix_entry_t)
+
+/*
+*   Bucket 0 holds the keys equal to @last, bucket i the keys whose highest
+*   bit that differs from @last is bit i - 1. @min_bucket and @min_index
+*   always point at the lowest key, the first nonempty bucket holds it
+*/
+struct radix_heap
+{
+    Bucket_t buckets[BUCKETS];
+    radix_key_t key_func;
+    unsigned long last;
+    size_t size;
+    size_t min_bucket;
+    size_t min_index;
+};
+
+/**********************Static Functions Implementation*************************/
+
+static size_t BucketOf(unsigned long last, unsigned long key)
+{
+    unsigned long diff = key ^ last;
+    size_t bits = 0;
+
+#ifdef __GNUC__
+    bits = diff ? KEY_BITS - __builtin_clzl(diff) : 0;
+#else
+    for(; diff; diff >>= 1)
+    {
+        ++bits;
+    }
+#endif
+
+    return bits;
+}
+
+static void FindMin(radix_heap_t* heap)
+{
+    Bucket_t* bucket = heap->buckets;
+    size_t i = 0;
+
+    if(!heap->size)
+    {
+        return;
+    }
+
+    while(!bucket->size)
+    {
+        ++bucket;
+    }
+
+    heap->min_bucket = bucket - heap->buckets;
+    heap->min_index = 0;
+
+    /* bucket 0 keys all equal @last */
+    for(i = 1; heap->min_bucket && i < bucket->size; ++i)
+    {
+        if(bucket->array[i].key < bucket->array[heap->min_index].key)
+        {
+            heap->min_index = i;
+        }
+    }
+}
+
+/*
+*   Makes room for moving buckets @first to @end - 1 by @new_last first, so
+*   the moves can't fail half way
+*/
+static int ReserveMoves(radix_heap_t* heap, size_t first, size_t end,
+                                                    unsigned long new_last)
+{
+    size_t incoming[BUCKETS] = {0};
+    size_t to = 0;
+    size_t i = 0;
+
+    for(; first < end; ++first)
+    {
+        for(i = 0; i < heap->buckets[first].size; ++i)
+        {
+            to = BucketOf(new_last, heap->buckets[first].array[i].key);
+            incoming[to] += to != first;
+        }
+    }
+
+    for(i = 0; i < BUCKETS; ++i)
+    {
+        if(incoming[i] && BucketReserve(heap->buckets + i,
+                                    heap->buckets[i].size + incoming[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* the keys of bucket @from all land in lower buckets by the new @last */
+static void MoveDown(radix_heap_t* heap, size_t from)
+{
+    Bucket_t* bucket = heap->buckets + from;
+    radix_entry_t* entry = bucket->array;
+    radix_entry_t* end = bucket->array + bucket->size;
+
+    for(; entry < end; ++entry)
+    {
+        BucketPushBack(heap->buckets + BucketOf(heap->last, entry->key),
+                                                                    *entry);
+    }
+
+    bucket->size = 0;
+}
+
+/* a key below @last moves every element */
+static int Rebase(radix_heap_t* heap, unsigned long new_last)
+{
+    size_t from = 0;
+    size_t i = 0;
+
+    if(ReserveMoves(heap, 0, BUCKETS, new_last))
+    {
+        return 1;
+    }
+
+    heap->last = new_last;
+
+    for(from = 0; from < BUCKETS; ++from)
+    {
+        Bucket_t* bucket = heap->buckets + from;
+
+        for(i = 0; i < bucket->size;)
+        {
+            size_t to = BucketOf(new_last, bucket->array[i].key);
+
+            if(to == from)
+            {
+                ++i;
+                continue;
+            }
+
+            BucketPushBack(heap->buckets + to, bucket->array[i]);
+            bucket->array[i] = bucket->array[--bucket->size];
+        }
+    }
+
+    return 0;
+}
+
+static void RemoveAt(radix_heap_t* heap, size_t from, size_t index)
+{
+    Bucket_t* bucket = heap->buckets + from;
+
+    bucket->array[index] = bucket->array[--bucket->size];
+    --heap->size;
+}
+
+/*****************************API Functions************************************/
+
+radix_heap_t* RadixCreate(radix_key_t key_func)
+{
+    radix_heap_t* heap = NULL;
+    size_t i = 0;
+
+    assert(key_func);
+
+    heap = (radix_heap_t*)malloc(sizeof(radix_heap_t));
+
+    if(!heap)
+    {
+        return NULL;
+    }
+
+    for(; i < BUCKETS; ++i)
+    {
+        if(BucketInit(heap->buckets + i, BUCKET_CAPACITY))
+        {
+            while(i--)
+            {
+                BucketDestroy(heap->buckets + i);
+            }
+
+            free(heap);
+            return NULL;
+        }
+    }
+
+    heap->key_func = key_func;
+    heap->last = 0;
+    heap->size = 0;
+    heap->min_bucket = 0;
+    heap->min_index = 0;
+
+    return heap;
+}
+
+void RadixDestroy(radix_heap_t* heap)
+{
+    size_t i = 0;
+
+    assert(heap);
+
+    for(; i < BUCKETS; ++i)
+    {
+        BucketDestroy(heap->buckets + i);
+    }
+
+    free(heap);
+}
+
+int RadixPush(radix_heap_t* heap, void* data)
+{
+    radix_entry_t entry;
+    int is_min = 0;
+    size_t to = 0;
+
+    assert(heap);
+
+    entry.key = heap->key_func(data);
+    entry.data = data;
+    is_min = !heap->size || entry.key <
+                    heap->buckets[heap->min_bucket].array[heap->min_index].key;
+
+    if(!heap->size)
+    {
+        heap->last = entry.key;
+    }
+    else if(entry.key < heap->last && Rebase(heap, entry.key))
+    {
+        return 1;
+    }
+
+    to = BucketOf(heap->last, entry.key);
+
+    if(BucketPushBack(heap->buckets + to, entry))
+    {
+        return 1;
+    }
+
+    ++heap->size;
+
+    if(is_min)
+    {
+        heap->min_bucket = to;
+        heap->min_index = heap->buckets[to].size - 1;
+    }
+
+    return 0;
+}
+
+int RadixPop(radix_heap_t* heap)
+{
+    size_t from = 0;
+    unsigned long key = 0;
+
+    assert(heap);
+    assert(heap->size);
+
+    from = heap->min_bucket;
+    key = heap->buckets[from].array[heap->min_index].key;
+    RemoveAt(heap, from, heap->min_index);
+
+    /*
+    *   The popped key becomes @last and the rest of its bucket moves down.
+    *   Without memory for the move @last stays, which is slower but correct
+    */
+    if(from && !ReserveMoves(heap, from, from + 1, key))
+    {
+        heap->last = key;
+        MoveDown(heap, from);
+    }
+
+    FindMin(heap);
+
+    return 0;
+}
+
+void* RadixPeek(const radix_heap_t* heap)
+{
+    assert(heap);
+    assert(heap->size);
+
+    return heap->buckets[heap->min_bucket].array[heap->min_index].data;
+}
+
+size_t RadixSize(const radix_heap_t* heap)
+{
+    assert(heap);
+
+    return heap->size;
+}
+
+int RadixIsEmpty(const radix_heap_t* heap)
+{
+    assert(heap);
+
+    return 0 == heap->size;
+}
+
+void* RadixRemove(radix_heap_t* heap, void* param, is_match_t is_match)
+{
+    Bucket_t* bucket = NULL;
+    void* data = NULL;
+    size_t from = 0;
+    size_t i = 0;
+
+    assert(heap);
+    assert(is_match);
+
+    for(; from < BUCKETS; ++from)
+    {
+        bucket = heap->buckets + from;
+
+        for(i = 0; i < bucket->size; ++i)
+        {
+            if(is_match(bucket->array[i].data, param))
+            {
+                data = bucket->array[i].data;
+                RemoveAt(heap, from, i);
+                FindMin(heap);
+
+                return data;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+size_t RadixRemoveAll(radix_heap_t* heap, void* param, is_match_t is_match)
+{
+    Bucket_t* bucket = NULL;
+    size_t removed = 0;
+    size_t from = 0;
+    size_t kept = 0;
+    size_t i = 0;
+
+    assert(heap);
+    assert(is_match);
+
+    for(; from < BUCKETS; ++from)
+    {
+        bucket = heap->buckets + from;
+
+        for(i = 0, kept = 0; i < bucket->size; ++i)
+        {
+            if(!is_match(bucket->array[i].data, param))
+            {
+                bucket->array[kept++] = bucket->array[i];
+            }
+        }
+
+        removed += bucket->size - kept;
+        bucket->size = kept;
+    }
+
+    heap->size -= removed;
+    FindMin(heap);
+
+    return removed;
+}
+
+int RadixReserve(radix_heap_t* heap, size_t capacity)
+{
+    size_t i = 0;
+
+    assert(heap);
+
+    for(; i < BUCKETS; ++i)
+    {
+        if(BucketReserve(heap->buckets + i, capacity))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
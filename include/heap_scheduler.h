@@ -4,9 +4,22 @@
 #include <stddef.h>     /* size_t */
 
 #include "ilrd_uid.h"   /* ilrd_uid_t */
+#include "task.h"       /* task_stats_t */
+#include "sched_clock.h" /* sched_clock_t */
 
 typedef struct scheduler scheduler_t;
 
+/*
+*   Identifies a task for @SchedulerCancel, or a task group. The generation is
+*   bumped every time the slot is reused, so a handle of a task that already
+*   finished never cancels a newer task.
+*/
+typedef struct sched_handle
+{
+    size_t slot;
+    unsigned long gen;
+} sched_handle_t;
+
 typedef enum sched_status
 {
     SCHED_SUCCESS   = 0,
@@ -15,6 +28,43 @@ typedef enum sched_status
     SCHED_RUNNING   = 3,
     SCHED_DESTROYED = 4
 } sched_status_t;
+
+/*
+*   Due critical tasks always run before normal tasks. Normal tasks get an
+*   execution budget, running past it counts as an overrun
+*/
+typedef enum sched_priority
+{
+    SCHED_CRITICAL = 0,
+    SCHED_NORMAL   = 1
+} sched_priority_t;
+
+/*
+*   Queue behind each lane. Run times only move forward, the radix heap
+*   makes the requeue after every run O(1)
+*/
+typedef enum sched_backend
+{
+    SCHED_BINARY_HEAP = 0,
+    SCHED_RADIX_HEAP  = 1
+} sched_backend_t;
+
+typedef void (*sched_overrun_t)(ilrd_uid_t uid, size_t run_usec, void* param);
+
+typedef struct sched_task_info
+{
+    ilrd_uid_t uid;
+    sched_handle_t handle;
+    task_action_t action_func;
+    time_t time_to_run;
+    size_t interval_in_sec;
+    sched_priority_t priority;
+    size_t budget_usec;
+    int is_running;
+    task_stats_t stats;
+} sched_task_info_t;
+
+typedef int (*sched_visit_t)(const sched_task_info_t* info, void* param);
  
 /* 
 *   @desc:          Allocates Scheduler and returns pointer.
@@ -26,11 +76,23 @@ typedef enum sched_status
 */ 
 scheduler_t* SchedulerCreate(void);
 
+/* 
+*   @desc:          Allocates Scheduler whose lanes are queued in @backend,
+*		    @SchedulerCreate uses SCHED_BINARY_HEAP
+*   @params: 	    @backend: queue implementation of the lanes
+*   @return value:  Pointer to the allocated Scheduler
+*   @error: 	    NULL if allocation fails
+*   @time complex:  O(malloc) for both AC/WC
+*   @space complex: O(malloc) for both AC/WC
+*/ 
+scheduler_t* SchedulerCreateBackend(sched_backend_t backend);
+
 /* 
 *   @desc:          Destroys and frees @scheduler. In the event the scheduler is
 *		    still running it will signal to @scheduler to destroy
 *		    itself, after the current task is done running and will 
-*		    return DESTROYED on	@SchedulerRun return value
+*		    return DESTROYED on	@SchedulerRun return value. A scheduler
+*		    waiting for its next task is woken right away
 *   @params: 	    @scheduler: pre allocated scheduler
 *   @return value:  None
 *   @error: 	    Undefined behavior if @scheduler is not valid
@@ -58,7 +120,7 @@ void SchedulerDestroy(scheduler_t* scheduler);
 *		    will return @bad_uid that is defined externally.
 *		    Undefined behavior if @scheduler is not valid or
 *                   @action_func is not valid
-*   @time complex:  O(n) for both AC/WC
+*   @time complex:  O(log n) AC, O(n) WC
 *   @space complex: O(1) for both AC/WC
 */
 ilrd_uid_t SchedulerAdd(scheduler_t* scheduler,
@@ -66,10 +128,34 @@ ilrd_uid_t SchedulerAdd(scheduler_t* scheduler,
 			size_t interval_in_sec);
 
 /* 
-*   @desc:          Removes a task from @scheduler identified by @identifier
-*		    Cannot be used in a task to remove itself from @scheduler.
-*                   Use the action func return value to remove a running task
-*                   from @scheduler				    
+*   @desc:          Adds a task as @SchedulerAdd does, in the lane of
+*		    @priority, optionally in @group and returning a handle.
+*		    @SchedulerAdd is this with SCHED_NORMAL and no group or
+*		    handle
+*   @params: 	    @scheduler, @action_func, @params, @interval_sec: as in
+*		    	@SchedulerAdd
+*		    @priority: lane of the task, normal tasks start with a
+*		    	budget of 100 milliseconds
+*		    @group: group from @SchedulerGroupCreate to join, NULL for
+*		    	none
+*		    @handle: output for @SchedulerCancel, may be NULL
+*   @return value:  Returns the unique uid of the newly added task.
+*   @error: 	    In the event that this function failed to add a new task,
+*		    or @group was cancelled, it will return @bad_uid that is
+*		    defined externally.
+*		    Undefined behavior if @scheduler is not valid or
+*                   @action_func is not valid
+*   @time complex:  O(log n) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+ilrd_uid_t SchedulerAddEx(scheduler_t* scheduler,
+			int (*action_func)(void* params), void* params,
+			size_t interval_in_sec, sched_priority_t priority,
+			const sched_handle_t* group, sched_handle_t* handle);
+
+/* 
+*   @desc:          Removes a task from @scheduler identified by @identifier.
+*		    Removing the running task cancels it, it won't run again
 *   @params: 	    @scheduler: pre allocated scheduler
 *		    @identifier: identifier to search for task to remove
 *   @return value:  zero if found and removed the task and nonzero if failed to
@@ -80,9 +166,269 @@ ilrd_uid_t SchedulerAdd(scheduler_t* scheduler,
 */
 int SchedulerRemove(scheduler_t* scheduler, ilrd_uid_t identifier);
 
+/* 
+*   @desc:          Marks the task of @handle as cancelled. A cancelled task
+*		    never runs again, it is freed when it reaches the top of
+*		    @scheduler or when @scheduler compacts. May be called from
+*		    any task, including the cancelled one, and from other
+*		    threads. A task cancelled while @scheduler waits for it
+*		    doesn't run, only a run already started finishes
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @handle: handle returned by @SchedulerAddEx
+*   @return value:  zero if the task was cancelled and nonzero if it already
+*		    finished or was cancelled before
+*   @error: 	    Undefined behavior if @scheduler is invalid or @handle
+*		    wasn't returned by @SchedulerAddEx of @scheduler
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerCancel(scheduler_t* scheduler, sched_handle_t handle);
+
+/* 
+*   @desc:          Creates an empty task group. Tasks join it through
+*		    @SchedulerAddEx, and the whole group is then cancelled,
+*		    paused or shifted at once at the cost of its own size,
+*		    whatever the size of @scheduler
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @group: output handle of the group
+*   @return value:  zero on success and nonzero if allocation failed
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(1) AC, O(groups) WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerGroupCreate(scheduler_t* scheduler, sched_handle_t* group);
+
+/* 
+*   @desc:          Cancels every task of @group and frees @group. A running
+*		    member finishes its run first, like with @SchedulerCancel
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @group: handle returned by @SchedulerGroupCreate
+*   @return value:  zero on success and nonzero if @group was already
+*		    cancelled
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(group size) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerGroupCancel(scheduler_t* scheduler, sched_handle_t group);
+
+/* 
+*   @desc:          Holds back every task of @group until
+*		    @SchedulerGroupResume. Their deadlines keep passing, a
+*		    member overdue on resume runs right away, once
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @group: handle returned by @SchedulerGroupCreate
+*   @return value:  zero on success and nonzero if @group was cancelled
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerGroupPause(scheduler_t* scheduler, sched_handle_t group);
+
+/* 
+*   @desc:          Lets the tasks of a paused @group run again. Resuming a
+*		    running group does nothing
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @group: handle returned by @SchedulerGroupCreate
+*   @return value:  zero on success and nonzero if @group was cancelled or
+*		    allocation failed
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(log groups) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerGroupResume(scheduler_t* scheduler, sched_handle_t group);
+
+/* 
+*   @desc:          Moves the next run of every task of @group by
+*		    @delta_sec, earlier if negative. A running member keeps
+*		    the next run it gets when it returns
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @group: handle returned by @SchedulerGroupCreate
+*		    @delta_sec: seconds to move by
+*   @return value:  zero on success and nonzero if @group was cancelled or
+*		    allocation failed
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(group size) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerGroupShift(scheduler_t* scheduler, sched_handle_t group,
+                                                            long delta_sec);
+
+/* 
+*   @desc:          Sets when @scheduler compacts. Once cancelled tasks make
+*		    up more than @percent of the queue they are all removed
+*		    in one pass. 0 disables compaction, cancelled tasks are
+*		    then only dropped from the top
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @percent: tombstone share in percents, default is 25
+*   @return value:  None
+*   @error: 	    Undefined behavior if @scheduler is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SchedulerSetCompaction(scheduler_t* scheduler, size_t percent);
+
+/* 
+*   @desc:          Sets how long each run of the task of @handle may take
+*		    before it counts as an overrun
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @handle: handle returned by @SchedulerAddEx
+*		    @budget_usec: budget in microseconds, 0 disables the check
+*   @return value:  zero on success and nonzero if the task already finished
+*		    or was cancelled
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerSetBudget(scheduler_t* scheduler, sched_handle_t handle,
+                                                            size_t budget_usec);
+
+/* 
+*   @desc:          Changes the interval of the task of @handle in place,
+*		    keeping its uid, lane, budget and stats. Its next run is
+*		    @interval_in_sec from now, a running task is requeued with
+*		    the new interval once it returns
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @handle: handle returned by @SchedulerAddEx
+*		    @interval_in_sec: new interval
+*   @return value:  zero on success and nonzero if the task already finished
+*		    or was cancelled
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerReschedule(scheduler_t* scheduler, sched_handle_t handle,
+                                                        size_t interval_in_sec);
+
+/* 
+*   @desc:          Puts back the interval, next run time, budget and stats
+*		    of @saved on the task of @handle, keeping its uid and lane.
+*		    Used to resume the timers of another process
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @handle: handle returned by @SchedulerAddEx
+*		    @saved: info of the task to resume, as filled by
+*		    	@SchedulerSnapshot, its uid and handle are ignored
+*   @return value:  zero on success and nonzero if the task already finished,
+*		    was cancelled or is running
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerRestoreTask(scheduler_t* scheduler, sched_handle_t handle,
+                                    const sched_task_info_t* saved);
+
+/* 
+*   @desc:          Makes room for @tasks tasks in every lane and in the
+*		    handle table up front. Once the tasks are added, running
+*		    and rescheduling them never allocates, as long as there
+*		    are at most @tasks of them
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @tasks: tasks to keep room for
+*   @return value:  zero on success and nonzero if allocation failed
+*   @error: 	    Undefined behavior if @scheduler is invalid
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(n) for both AC/WC
+*/
+int SchedulerReserve(scheduler_t* scheduler, size_t tasks);
+
+/* 
+*   @desc:          Makes @scheduler and its tasks read @clock instead of the
+*		    real clocks. On a simulated clock @SchedulerRun never
+*		    sleeps, it jumps the clock to the next deadline, so a
+*		    schedule of hours runs in as long as its actions take and
+*		    the same way every time
+*   @params: 	    @scheduler: pre allocated scheduler, still empty
+*		    @clock: time source, NULL for the real clocks. Must outlive
+*		    	@scheduler
+*   @return value:  None
+*   @error: 	    Undefined behavior if @scheduler holds tasks
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SchedulerSetClock(scheduler_t* scheduler, sched_clock_t* clock);
+
+/*
+*   @desc:          Starts logging every add, remove and run of @scheduler,
+*		    and the stop of its run loop, to @path in the format of
+*		    sched_trace.h, timed on the clock of @scheduler. Records
+*		    are buffered and written in batches. A removal is logged
+*		    when it's asked for, group pauses and shifts aren't logged
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @path: file to create or truncate, NULL to flush and close
+*		    	the current trace
+*   @return value:  zero on success and nonzero if @path can't be opened or
+*		    a write failed
+*   @error: 	    Other threads may cancel tasks while the trace starts or
+*		    stops, but only one thread may call it at a time
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int SchedulerRecord(scheduler_t* scheduler, const char* path);
+
+/* 
+*   @desc:          Sets @handler to be called with @param after every run
+*		    that went over its budget
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @handler: overrun handler, NULL to only count overruns
+*		    @param: user param passed to @handler
+*   @return value:  None
+*   @error: 	    Undefined behavior if @scheduler is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SchedulerSetOverrunHandler(scheduler_t* scheduler,
+                                    sched_overrun_t handler, void* param);
+
+/* 
+*   @desc:          Returns how many runs went over their budget
+*/
+size_t SchedulerOverruns(const scheduler_t* scheduler);
+
+/* 
+*   @desc:          Calls @visit with the info of every task in @scheduler,
+*		    the running one included, without dequeuing them. Tasks
+*		    are visited in no particular order. Stops early once
+*		    @visit returns nonzero
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @visit: user function, @info is valid only during the call
+*		    @param: user param passed to @visit
+*   @return value:  The count of visited tasks
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t SchedulerForEach(const scheduler_t* scheduler, sched_visit_t visit,
+                                                                void* param);
+
+/* 
+*   @desc:          Copies the info of up to @max tasks of @scheduler to
+*		    @infos, sorted by their next run time. If @scheduler holds
+*		    more than @max tasks the copied ones aren't necessarily
+*		    the earliest
+*   @params: 	    @scheduler: pre allocated scheduler
+*		    @infos: output array of @max entries
+*		    @max: capacity of @infos
+*   @return value:  The count of copied entries
+*   @error: 	    Undefined behavior if @scheduler is invalid or if called
+*		    from another thread than the one running @scheduler
+*   @time complex:  O(n + max log max) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t SchedulerSnapshot(const scheduler_t* scheduler,
+                                        sched_task_info_t* infos, size_t max);
+
 /* 
 *   @desc:          Starts running @scheduler or if already running will return
-*		    @RUNNING status code
+*		    @RUNNING status code. If @SchedulerStop was called before
+*		    the run, it returns @STOPPED right away
 *   @params: 	    @scheduler: pre allocated scheduler
 *   @return value:  status code of the running process:
 *		    @SUCCESS means it ended successfully without getting called
@@ -98,7 +444,9 @@ int SchedulerRemove(scheduler_t* scheduler, ilrd_uid_t identifier);
 sched_status_t SchedulerRun(scheduler_t* scheduler);
 
 /* 
-*   @desc:          Sends a signal to the scheduler to stop @scheduler
+*   @desc:          Sends a signal to the scheduler to stop @scheduler. A
+*		    scheduler waiting for its next task stops right away. Safe
+*		    to call from a signal handler
 *   @params: 	    @scheduler: pre allocated scheduler
 *   @return value:  None
 *   @error: 	    Undefined behavior if @scheduler is invalid
@@ -108,11 +456,12 @@ sched_status_t SchedulerRun(scheduler_t* scheduler);
 void SchedulerStop(scheduler_t* scheduler);
 
 /* 
-*   @desc:          Counts the amount of tasks currently in @scheduler
+*   @desc:          Counts the amount of tasks currently in @scheduler,
+*		    not counting cancelled tasks
 *   @params: 	    @scheduler: pre allocated scheduler
 *   @return value:  Returns the count of tasks in @scheduler
 *   @error: 	    Undefined behavior if @scheduler is invalid
-*   @time complex:  O(n) for both AC/WC
+*   @time complex:  O(1) for both AC/WC
 *   @space complex: O(1) for both AC/WC
 */
 size_t SchedulerSize(const scheduler_t* scheduler);
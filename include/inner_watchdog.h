@@ -4,10 +4,27 @@
 #include <stddef.h>         /* size_t */
 
 #include "heap_scheduler.h"
+#include "watchdog.h"       /* wd_action_t, wd_hook_t */
 
 #define SEM_NAME ("/WatchDog")
 #define ENV_VAR_NAME ("WD_PID")
+#define BUDGET_ENV_NAME ("WD_BUDGET")
+#define RESTARTS_ENV_NAME ("WD_RESTARTS")
+#define SOCKET_ENV_NAME ("WD_SOCK_FD")
+#define LISTEN_ENV_NAME ("WD_LISTEN_FDS")
+#define CONFIG_ENV_NAME ("WD_CONFIG")
+#define TRANSPORT_ENV_NAME ("WD_TRANSPORT")
+#define RT_ENV_NAME ("WD_RT")
+#define RT_RESERVE_TASKS (16)
+#define SNAPSHOT_PATH_CLIENT ("/tmp/WatchDog.client.snap")
+#define SNAPSHOT_PATH_SERVER ("/tmp/WatchDog.server.snap")
+#define SNAPSHOT_PATH_INPROC ("/tmp/WatchDog.inproc.snap")
 #define BUFSIZE (64)
+#define MAX_GRACE_ROUNDS (3)
+#define BACKOFF_BASE_MS (100)
+#define BACKOFF_MAX_MS (30000)
+#define RESTART_BUDGET (5)
+#define RESTART_WINDOW_SEC (60)
 
 #ifndef NDEBUG
 
@@ -21,11 +38,24 @@
 
 typedef enum wd_type {
     CLIENT,
-    SERVER
+    SERVER,
+    INPROC
 } wd_type_t;
 
 
 int RunWD(size_t threshold, size_t interval, int argc, char** argv,
                                                             wd_type_t location);
 
+/* in process mode: set the action before RunWD, wait for it to be up */
+void InProcessInit(wd_action_t action, wd_hook_t hook, void* param);
+
+int InProcessWait(void);
+
+void InProcessStop(void);
+
+/* held by StopWD, a server revival in flight finishes or is called off */
+void ReviveLock(void);
+
+void ReviveUnlock(void);
+
 #endif  /*__WATCHDOG_H__*/
\ No newline at end of file
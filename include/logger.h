@@ -1,6 +1,19 @@
 #ifndef __LOGGER_H__
 #define __LOGGER_H__
 
+typedef enum log_level {
+    LOG_QUIET,
+    LOG_EVENTS,
+    LOG_VERBOSE
+} log_level_t;
+
+/* logged at LOG_EVENTS and up */
 int UploadMessage(const char* filename, const char* message, int location);
 
+/* per heartbeat messages, logged at LOG_VERBOSE only */
+int UploadVerbose(const char* filename, const char* message, int location);
+
+/* LOG_VERBOSE by default */
+void LoggerSetLevel(log_level_t level);
+
 #endif  /*__LOGGER_H__*/
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef __SCHED_CLOCK_H__
+#define __SCHED_CLOCK_H__
+
+#include <stddef.h>     /* size_t */
+#include <time.h>       /* time_t, struct timespec */
+
+/*
+*   The time source of a scheduler and its tasks. NULL stands for the real
+*   clocks: time(), CLOCK_REALTIME and CLOCK_MONOTONIC. A simulated clock
+*   only moves when told to, and a scheduler running on one jumps it
+*   straight to the next deadline instead of sleeping, so hours of
+*   schedule run in as long as the actions take and always the same way.
+*   A simulated clock is used by one thread, the one running the scheduler.
+*/
+
+typedef struct sched_clock sched_clock_t;
+
+/* -ansi builds without POSIX headers only see it by name */
+struct timespec;
+
+/*
+*   @desc:          Allocates a simulated clock reading @start seconds
+*   @params:        @start: initial time, in the epoch of time()
+*   @return value:  Pointer to the clock
+*   @error:         NULL if allocation fails
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+sched_clock_t* ClockCreateSimulated(time_t start);
+
+/*
+*   @desc:          Frees @clock, NULL is ignored
+*/
+void ClockDestroy(sched_clock_t* clock);
+
+/*
+*   @desc:          Reads @clock, in whole seconds as time() does
+*/
+time_t ClockTime(const sched_clock_t* clock);
+
+/*
+*   @desc:          Reads @clock as CLOCK_REALTIME does
+*/
+void ClockRealtime(const sched_clock_t* clock, struct timespec* now);
+
+/*
+*   @desc:          Reads @clock as CLOCK_MONOTONIC does. A simulated clock
+*                   has one time line, the same as its realtime
+*/
+void ClockMonotonic(const sched_clock_t* clock, struct timespec* now);
+
+/*
+*   @desc:          Moves simulated @clock forward by @usec, for an action
+*                   that models how long it runs
+*   @params:        @clock: simulated clock
+*                   @usec: microseconds to add
+*   @return value:  None
+*   @error:         Undefined behavior if @clock is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ClockAdvance(sched_clock_t* clock, size_t usec);
+
+/*
+*   @desc:          Moves simulated @clock forward to @when seconds. A @when
+*                   in its past leaves it as it is
+*   @params:        @clock: simulated clock
+*                   @when: time to jump to
+*   @return value:  None
+*   @error:         Undefined behavior if @clock is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ClockJumpTo(sched_clock_t* clock, time_t when);
+
+#endif /* __SCHED_CLOCK_H__ */
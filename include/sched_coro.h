@@ -0,0 +1,108 @@
+#ifndef __SCHED_CORO_H__
+#define __SCHED_CORO_H__
+
+#include <stddef.h>             /* size_t */
+
+#include "heap_scheduler.h"     /* scheduler_t */
+
+/*
+*   Stackless coroutines resumed from the scheduler loop. A single pump task
+*   resumes every due coroutine on each tick, so coroutines cost neither a
+*   thread nor a scheduler task each, and their frames come from a pool.
+*
+*   State that must survive a suspension lives in @CoLocals, not on the
+*   stack:
+*
+*   static co_status_t Probe(co_frame_t* frame, void* params)
+*   {
+*       probe_locals_t* locals = CoLocals(frame);
+*
+*       CO_BEGIN(frame);
+*
+*       for(locals->tries = 0; locals->tries < 3; ++locals->tries)
+*       {
+*           SendProbe(params);
+*           CO_SLEEP_FOR(frame, 5);
+*       }
+*
+*       CO_END(frame);
+*   }
+*/
+
+typedef struct co_runtime co_runtime_t;
+typedef struct co_frame co_frame_t;
+
+typedef enum co_status
+{
+    CO_DONE      = 0,
+    CO_SUSPENDED = 1
+} co_status_t;
+
+typedef co_status_t (*co_func_t)(co_frame_t* frame, void* params);
+
+#define CO_BEGIN(frame) switch(CoResumePoint(frame)) { case 0:
+
+#define CO_SLEEP_FOR(frame, ticks)                                             \
+    do                                                                         \
+    {                                                                          \
+        return CoSuspend((frame), (ticks), __LINE__);                          \
+        case __LINE__:;                                                        \
+    } while(0)
+
+#define CO_NEXT_TICK(frame) CO_SLEEP_FOR(frame, 1)
+
+#define CO_END(frame) } return CO_DONE
+
+/*
+*   @desc:          Creates a coroutine runtime pumped by a task added to
+*                   @scheduler every @tick_sec seconds
+*   @params:        @scheduler: pre allocated scheduler
+*                   @tick_sec: seconds between pump runs
+*                   @locals_size: bytes of @CoLocals every frame gets
+*   @return value:  Pointer to the runtime
+*   @error:         NULL if allocation or adding the pump task fails
+*   @time complex:  O(malloc) for both AC/WC
+*   @space complex: O(malloc) for both AC/WC
+*/
+co_runtime_t* CoRuntimeCreate(scheduler_t* scheduler, size_t tick_sec,
+                                                        size_t locals_size);
+
+/*
+*   @desc:          Removes the pump task and frees every frame, including
+*                   frames of coroutines that didn't finish
+*   @params:        @runtime: runtime created with @CoRuntimeCreate
+*   @return value:  None
+*   @error:         Undefined behavior if called from a coroutine
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void CoRuntimeDestroy(co_runtime_t* runtime);
+
+/*
+*   @desc:          Starts a coroutine running @func with @params on the next
+*                   tick. Its locals are zeroed
+*   @params:        @runtime: runtime created with @CoRuntimeCreate
+*                   @func: coroutine body
+*                   @params: user params passed to @func on every resume
+*   @return value:  0 on success, nonzero otherwise
+*   @error:         Fails if the frame pool can't grow
+*   @time complex:  O(log n) AC, O(n) WC when the pool grows
+*   @space complex: O(1) AC, O(chunk) WC
+*/
+int CoSpawn(co_runtime_t* runtime, co_func_t func, void* params);
+
+/*
+*   @desc:          Returns the number of live coroutines in @runtime
+*/
+size_t CoCount(const co_runtime_t* runtime);
+
+/*
+*   @desc:          Returns the locals area of @frame
+*/
+void* CoLocals(co_frame_t* frame);
+
+/* used by the CO_* macros */
+int CoResumePoint(const co_frame_t* frame);
+co_status_t CoSuspend(co_frame_t* frame, size_t ticks, int resume_point);
+
+#endif /* __SCHED_CORO_H__ */
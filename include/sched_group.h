@@ -0,0 +1,105 @@
+#ifndef __SCHED_GROUP_H__
+#define __SCHED_GROUP_H__
+
+#include <stddef.h>             /* size_t */
+
+#include "ilrd_uid.h"           /* ilrd_uid_t */
+
+/*
+*   A group of scheduler shards, one thread each, for workloads too big for
+*   one @scheduler_t, like thousands of probes. A task is pinned to the
+*   shard its key hashes to and always goes back to it, so tasks of one
+*   key stay together. A shard with nothing due steals due tasks from the
+*   others, so a hot shard doesn't fall behind while the rest idle.
+*/
+
+typedef struct sched_group sched_group_t;
+
+typedef struct sched_shard_stats
+{
+    size_t tasks;
+    size_t runs;
+    size_t steals;
+} sched_shard_stats_t;
+
+/*
+*   @desc:          Allocates a group of @shards shards
+*   @params:        @shards: shard count, 0 for one per online core
+*   @return value:  Pointer to the group
+*   @error:         NULL if allocation fails
+*   @time complex:  O(shards) for both AC/WC
+*   @space complex: O(shards) for both AC/WC
+*/
+sched_group_t* SchedGroupCreate(size_t shards);
+
+/*
+*   @desc:          Stops @group if it runs and frees it with all its tasks
+*   @params:        @group: group created with @SchedGroupCreate
+*   @return value:  None
+*   @error:         Undefined behavior if called from a task of @group
+*   @time complex:  O(n) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SchedGroupDestroy(sched_group_t* group);
+
+/*
+*   @desc:          Adds a task running @action_func with @params every
+*                   @interval_in_sec, as @SchedulerAdd does, to the shard
+*                   @key hashes to. May be called from any thread, tasks
+*                   included
+*   @params:        @group: group created with @SchedGroupCreate
+*                   @action_func: returns 0 to repeat, nonzero to stop
+*                   @params: user params passed to @action_func
+*                   @interval_in_sec: seconds between runs
+*                   @key: pins the task, tasks with the same key share a shard
+*   @return value:  The uid of the new task
+*   @error:         @bad_uid if allocation fails
+*   @time complex:  O(1) amortized
+*   @space complex: O(1) amortized
+*/
+ilrd_uid_t SchedGroupAdd(sched_group_t* group,
+                        int (*action_func)(void* params), void* params,
+                        size_t interval_in_sec, size_t key);
+
+/*
+*   @desc:          Starts a thread per shard, each pinned to its own core
+*                   when there are enough
+*   @params:        @group: group created with @SchedGroupCreate
+*   @return value:  0 on success, nonzero otherwise
+*   @error:         On failure the started threads are stopped again
+*   @time complex:  O(shards) for both AC/WC
+*   @space complex: O(shards) for both AC/WC
+*/
+int SchedGroupStart(sched_group_t* group);
+
+/*
+*   @desc:          Stops every shard after its current task and waits for
+*                   the threads. The tasks stay, @SchedGroupStart resumes them
+*   @params:        @group: group created with @SchedGroupCreate
+*   @return value:  None
+*   @error:         Undefined behavior if called from a task of @group
+*   @time complex:  O(shards) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SchedGroupStop(sched_group_t* group);
+
+/*
+*   @desc:          Returns the count of tasks in @group
+*/
+size_t SchedGroupSize(const sched_group_t* group);
+
+/*
+*   @desc:          Copies the counters of up to @max shards of @group to
+*                   @stats, may be called while @group runs
+*   @params:        @group: group created with @SchedGroupCreate
+*                   @stats: output array of @max entries
+*                   @max: capacity of @stats
+*   @return value:  The count of copied entries
+*   @error:         None
+*   @time complex:  O(shards) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t SchedGroupStats(const sched_group_t* group, sched_shard_stats_t* stats,
+                                                                size_t max);
+
+#endif /* __SCHED_GROUP_H__ */
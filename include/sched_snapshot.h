@@ -0,0 +1,74 @@
+#ifndef __SCHED_SNAPSHOT_H__
+#define __SCHED_SNAPSHOT_H__
+
+#include <stddef.h>             /* size_t */
+
+#include "heap_scheduler.h"     /* scheduler_t */
+#include "task.h"               /* task_action_t */
+
+#define SNAPSHOT_MAX_TASKS (32)
+
+/*
+*   The task table of a scheduler (deadlines, intervals, budgets and stats)
+*   kept in a memory-mapped file, so the process that takes over after a
+*   revival resumes the same timers instead of starting them over. Function
+*   addresses change across an exec, so tasks are bound by their index in
+*   an action table both processes pass in the same order. Tasks whose action
+*   isn't in the table aren't saved.
+*/
+
+typedef struct sched_snapshot sched_snapshot_t;
+
+/*
+*   @desc:          Maps the snapshot file at @path, creating it if needed
+*   @params:        @path: file path
+*                   @actions: the action table, kept by reference
+*                   @count: count of entries in @actions
+*   @return value:  Pointer to the snapshot
+*   @error:         NULL if the file can't be opened or mapped
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+sched_snapshot_t* SnapshotOpen(const char* path, const task_action_t* actions,
+                                                                size_t count);
+
+/*
+*   @desc:          Unmaps @snapshot, removing the file if @remove is nonzero
+*/
+void SnapshotClose(sched_snapshot_t* snapshot, int remove);
+
+/*
+*   @desc:          Writes the bound tasks of @scheduler to @snapshot. The
+*                   mapping is shared, so the file is up to date even if the
+*                   process dies right after. A save cut short by a crash is
+*                   detected and never restored
+*   @params:        @snapshot: snapshot returned by @SnapshotOpen
+*                   @scheduler: pre allocated scheduler
+*   @return value:  The count of saved tasks
+*   @error:         Undefined behavior if called from another thread than
+*                   the one running @scheduler
+*   @time complex:  O(n + SNAPSHOT_MAX_TASKS log SNAPSHOT_MAX_TASKS)
+*   @space complex: O(SNAPSHOT_MAX_TASKS) for both AC/WC
+*/
+size_t SnapshotSave(sched_snapshot_t* snapshot, const scheduler_t* scheduler);
+
+/*
+*   @desc:          Resumes the tasks of @scheduler from @snapshot. Every
+*                   saved task is matched to a task of @scheduler with the
+*                   same action and gets its interval, next run time, budget
+*                   and stats back. A next run time more than an interval
+*                   away, after the clock went back, is pulled in to one
+*                   interval
+*   @params:        @snapshot: snapshot returned by @SnapshotOpen
+*                   @scheduler: scheduler with its tasks already added
+*                   @max_age_sec: snapshots saved longer ago are ignored
+*   @return value:  The count of resumed tasks
+*   @error:         Undefined behavior if called from another thread than
+*                   the one running @scheduler
+*   @time complex:  O(n * SNAPSHOT_MAX_TASKS) for both AC/WC
+*   @space complex: O(SNAPSHOT_MAX_TASKS) for both AC/WC
+*/
+size_t SnapshotRestore(const sched_snapshot_t* snapshot,
+                                scheduler_t* scheduler, size_t max_age_sec);
+
+#endif /* __SCHED_SNAPSHOT_H__ */
@@ -0,0 +1,48 @@
+#ifndef __SCHED_TRACE_H__
+#define __SCHED_TRACE_H__
+
+/*
+*   The file @SchedulerRecord writes: one sched_trace_header_t, then one
+*   fixed size sched_trace_record_t per event in the order they happened,
+*   in the byte order of the recording machine. A task is named by its
+*   handle slot, which a later task may reuse once it's gone, so an id only
+*   stands for one task from its TRACE_ADD until the TRACE_REMOVE or the
+*   TRACE_RUN with @result set that ends it.
+*
+*   TRACE_ADD       @lane, @value: interval in seconds
+*   TRACE_REMOVE    cancelled or removed, at the time of the call
+*   TRACE_RUN       @value: run time in usec, @result: the action returned
+*                   nonzero and the task is done
+*   TRACE_STOP      the run loop stopped
+*/
+
+#define SCHED_TRACE_MAGIC (0x57445452UL)
+#define SCHED_TRACE_VERSION (1)
+
+typedef enum sched_trace_event
+{
+    TRACE_ADD    = 0,
+    TRACE_REMOVE = 1,
+    TRACE_RUN    = 2,
+    TRACE_STOP   = 3
+} sched_trace_event_t;
+
+typedef struct sched_trace_header
+{
+    unsigned long magic;
+    unsigned int version;
+    unsigned int record_size;
+} sched_trace_header_t;
+
+typedef struct sched_trace_record
+{
+    unsigned long usec;
+    unsigned int task;
+    unsigned int value;
+    unsigned char event;
+    unsigned char lane;
+    unsigned char result;
+    unsigned char reserved;
+} sched_trace_record_t;
+
+#endif /* __SCHED_TRACE_H__ */
@@ -4,9 +4,24 @@
 #include <stddef.h>   /* size_t */
 
 #include "ilrd_uid.h" /* ilrd_uid_t */
+#include "sched_clock.h" /* sched_clock_t */
 
 typedef struct task task_t;
 
+typedef int (*task_action_t)(void* params);
+
+/*
+*   Accounting of every run of a task. Lateness is how long after its
+*   @time_to_run the action started
+*/
+typedef struct task_stats
+{
+    size_t run_count;
+    unsigned long total_run_usec;
+    size_t max_run_usec;
+    size_t max_late_usec;
+} task_stats_t;
+
 /* 
 *   @desc:          Allocates new task must be destroyed with @TaskDestroy
 *   @params: 	    @action_func: the function the task will call when it runs
@@ -36,8 +51,9 @@ task_t* TaskCreate(int (*action_func)(void* params), void* params,
 void TaskDestroy(task_t* task);
 
 /*
-*   @desc:          Runs the action of @task and updates the next time this
-*		    task should operate
+*   @desc:          Runs the action of @task right away, waiting for it to be
+*		    due is up to the caller. The time the action took is kept
+*		    for @TaskGetRunTime and added to the stats of @task
 *   @params: 	    @task: pre allocated task
 *   @return value:  Returns the @task's action return value which was described
 *		    @TaskCreate
@@ -71,6 +87,84 @@ time_t TaskGetTimeToRun(const task_t* task);
 
 void TaskSetTimeToRun(task_t* task1);
 
+/*
+*   @desc:          Sets the interval of @task, its next run is @interval_in_sec
+*		    from now
+*   @params: 	    @task: pre allocated task
+*		    @interval_in_sec: new interval
+*   @return value:  None
+*   @error: 	    Undefined behavior if @task is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetInterval(task_t* task, size_t interval_in_sec);
+
+/*
+*   @desc:          Makes @task read @clock, NULL for the real clocks, and
+*		    sets its next run an interval from the time on @clock
+*   @params: 	    @task: pre allocated task
+*		    @clock: time source, must outlive @task
+*   @return value:  None
+*   @error: 	    Undefined behavior if @task is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetClock(task_t* task, const sched_clock_t* clock);
+
+/*
+*   @desc:          Returns how long the last action of @task ran, waiting for
+*		    it to be due excluded
+*   @params: 	    @task: pre allocated task
+*   @return value:  Run time in microseconds, 0 if it didn't run yet
+*   @error: 	    Undefined behavior if @task is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t TaskGetRunTime(const task_t* task);
+
+/*
+*   @desc:          Returns the action function of @task
+*/
+task_action_t TaskGetAction(const task_t* task);
+
+/*
+*   @desc:          Puts back the next run time and the stats of @task, as
+*		    saved by another process
+*   @params: 	    @task: pre allocated task
+*		    @time_to_run: next run time
+*		    @stats: run accounting to continue from
+*   @return value:  None
+*   @error: 	    Undefined behavior if @task or @stats is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskRestore(task_t* task, time_t time_to_run, const task_stats_t* stats);
+
+/*
+*   @desc:          Moves the next run of @task by @delta_sec, earlier if
+*		    negative
+*/
+void TaskShift(task_t* task, long delta_sec);
+
+/*
+*   @desc:          Copies the run accounting of @task to @stats
+*   @params: 	    @task: pre allocated task
+*		    @stats: output
+*   @return value:  None
+*   @error: 	    Undefined behavior if @task or @stats is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskGetStats(const task_t* task, task_stats_t* stats);
+
+/*
+*   @desc:          Gets and sets the scheduler slot of @task, used to find its
+*		    cancellation state
+*/
+size_t TaskGetSlot(const task_t* task);
+
+void TaskSetSlot(task_t* task, size_t slot);
+
 /*
 *   @desc:          Returns if @task1 and @task2 are the same task
 *   @params: 	    @task: pre allocated task
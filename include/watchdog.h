@@ -3,13 +3,281 @@
 
 #include <stddef.h>         /* size_t */
 
+#define WD_MAX_THREADS (64)
+#define WD_MAX_STATE_REGIONS (8)
+#define WD_STATE_NAME_MAX (32)
+#define WD_MAX_LISTEN_FDS (16)
+
 typedef enum wd_status {
     WD_SUCCESS,
     WD_FAILED
 } wd_status_t;
 
+typedef struct wd_budget {
+    size_t max_rss_kb;
+    size_t max_fds;
+    size_t max_cpu_percent;
+    size_t breach_samples;
+} wd_budget_t;
+
+typedef struct wd_metrics {
+    size_t client_restarts;
+    size_t server_restarts;
+    size_t backoff_ms;
+    int degraded;
+    size_t beats_received;
+    size_t beats_lost;
+    size_t beats_unsent;
+    size_t last_latency_us;
+    size_t max_latency_us;
+    size_t mean_latency_us;
+} wd_metrics_t;
+
+typedef enum wd_transport {
+    WD_TRANSPORT_SIGUSR,
+    WD_TRANSPORT_RTSIG
+} wd_transport_t;
+
+typedef struct wd_rt {
+    int cpu;
+    int priority;
+} wd_rt_t;
+
+typedef enum wd_action {
+    WD_ACTION_REEXEC,
+    WD_ACTION_ABORT,
+    WD_ACTION_HOOK
+} wd_action_t;
+
+typedef void (*wd_ready_t)(wd_status_t status, void* param);
+
+typedef void (*wd_hook_t)(void* param);
+
 wd_status_t StartWD(size_t threshold, size_t interval, int argc, char** argv);
 
 void StopWD(void);
 
+/*
+*   @desc:          Starts the watchdog like @StartWD without waiting for it.
+*                   Once both sides are up, or the start failed, @on_ready is
+*                   called from a helper thread with the result of @StartWD.
+*                   @StopWD may be called at any time after, it waits for the
+*                   start to finish first
+*   @params:        Same as @StartWD
+*                   @on_ready: readiness callback, may be NULL
+*                   @param: user param passed to @on_ready
+*   @return value:  WD_SUCCESS if the start began, WD_FAILED otherwise
+*   @error:         Undefined behavior if called again before @StopWD
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t StartWDAsync(size_t threshold, size_t interval, int argc,
+                            char** argv, wd_ready_t on_ready, void* param);
+
+/*
+*   @desc:          Returns 1 if the watchdog is up, 0 if it is still starting
+*                   or was stopped
+*/
+int WDIsReady(void);
+
+/*
+*   @desc:          Starts the watchdog as a thread of the app instead of a
+*                   companion process, with no fork, exec or named semaphore.
+*                   It watches the threads registered with @WDRegisterThread
+*                   and the budgets of @WDSetBudget, and once a thread misses
+*                   @threshold intervals or a budget is breached it:
+*                   WD_ACTION_REEXEC - re-executes @argv after the restart
+*                   backoff, keeping shared listening fds and state regions
+*                   WD_ACTION_ABORT - aborts, leaving a core dump
+*                   WD_ACTION_HOOK - calls @hook with @param from the watchdog
+*                   thread and keeps watching
+*                   Stopped with @StopWD
+*   @params:        @threshold, @interval, @argc, @argv: as in @StartWD,
+*                   @argv[0] is the program to re-execute
+*                   @action: what to do on failure
+*                   @hook: user hook for WD_ACTION_HOOK, ignored otherwise
+*                   @param: user param passed to @hook
+*   @return value:  WD_SUCCESS on success, WD_FAILED otherwise
+*   @error:         Undefined behavior if @action is WD_ACTION_HOOK and
+*                   @hook is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t StartWDInProcess(size_t threshold, size_t interval, int argc,
+                char** argv, wd_action_t action, wd_hook_t hook, void* param);
+
+/*
+*   @desc:          Sets resource budgets for the client. The watchdog process
+*                   samples the client every @interval and revives it once a
+*                   budget was breached on @breach_samples consecutive samples.
+*                   Must be called before @StartWD to take effect
+*   @params:        @budget: limits to apply, a zero limit is unlimited.
+*                   @max_cpu_percent is measured per sample against one core
+*   @return value:  WD_SUCCESS on success, WD_FAILED otherwise
+*   @error:         Undefined behavior if @budget is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t WDSetBudget(const wd_budget_t* budget);
+
+/*
+*   @desc:          Sets how the heartbeats travel. WD_TRANSPORT_SIGUSR, the
+*                   default, sends plain SIGUSR1, so beats pending together
+*                   merge into one. WD_TRANSPORT_RTSIG queues a real-time
+*                   signal with a sequence number and a send timestamp, so
+*                   every beat arrives, lost beats are counted exactly and the
+*                   one-way latency is measured. Beats of any process but the
+*                   peer, like ones still queued from a replaced peer, are
+*                   ignored. Must be called before @StartWD to take effect
+*   @params:        @transport: heartbeat transport
+*   @return value:  WD_SUCCESS on success, WD_FAILED otherwise
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t WDSetTransport(wd_transport_t transport);
+
+/*
+*   @desc:          Turns on real-time mode for the watchdog thread of the
+*                   app and for the watchdog process. Each side reserves its
+*                   scheduler up front, locks its memory with mlockall and
+*                   runs at SCHED_FIFO @rt->priority pinned to @rt->cpu, so
+*                   neither paging nor a busy machine delays a heartbeat.
+*                   After startup the watchdog allocates nothing until a
+*                   revival, which a build with -DWD_RT_MALLOC_CHECK aborts
+*                   on. Only the watchdog process locks its future mappings,
+*                   in the app only the pages mapped at startup are locked.
+*                   A step that lacks privileges is skipped, and `wdctl
+*                   status` reports it. Must be called before @StartWD to
+*                   take effect
+*   @params:        @rt: @cpu to pin to, -1 for any. @priority from 1 to 99,
+*                   0 keeps the normal policy
+*   @return value:  WD_SUCCESS on success, WD_FAILED otherwise
+*   @error:         Undefined behavior if @rt is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t WDSetRealtime(const wd_rt_t* rt);
+
+/*
+*   @desc:          Reports how many times the client and the watchdog process
+*                   were revived, the last backoff delay applied before a
+*                   revival and whether either side is crash looping, which
+*                   holds until it stays up for a whole restart window.
+*                   With WD_TRANSPORT_RTSIG it also reports the beats the
+*                   client received from the watchdog process, the ones lost
+*                   on the way, the ones the client couldn't queue, and the
+*                   last, max and mean one-way latency. These are zero with
+*                   WD_TRANSPORT_SIGUSR
+*   @params:        @metrics: output
+*   @return value:  None
+*   @error:         Undefined behavior if @metrics is NULL
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WDGetMetrics(wd_metrics_t* metrics);
+
+/*
+*   @desc:          Attaches a named shared memory region that survives the
+*                   revival of the client. A revived client attaching with the
+*                   same @name, @size and @version gets its state back warm,
+*                   as long as it was left valid by @WDStateCommit
+*   @params:        @name: region name, at most @WD_STATE_NAME_MAX characters
+*                   @size: bytes of state
+*                   @version: layout version of the state, a mismatch starts
+*                   cold
+*                   @is_warm: output, 1 if the previous content is valid and
+*                   0 if the region was zeroed
+*   @return value:  Pointer to the state
+*   @error:         Returns NULL if all @WD_MAX_STATE_REGIONS are attached or
+*                   the region couldn't be created
+*   @time complex:  O(size) for WC, O(1) for AC
+*   @space complex: O(size) for both AC/WC
+*/
+void* WDStateAttach(const char* name, size_t size, unsigned int version,
+                                                                int* is_warm);
+
+/*
+*   @desc:          Marks @state as consistent, so a revived client may reuse
+*                   it. Call @WDStateInvalidate before changing it again
+*   @params:        @state: pointer returned from @WDStateAttach
+*   @return value:  None
+*   @error:         Undefined behavior if @state is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WDStateCommit(void* state);
+
+/*
+*   @desc:          Marks @state as being changed, a client revived before the
+*                   next @WDStateCommit starts cold
+*   @params:        @state: pointer returned from @WDStateAttach
+*   @return value:  None
+*   @error:         Undefined behavior if @state is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WDStateInvalidate(void* state);
+
+/*
+*   @desc:          Hands the listening socket @fd to the watchdog process,
+*                   which keeps it open and passes it on to the revived
+*                   client, so pending connections and the accept backlog
+*                   survive the revival
+*   @params:        @fd: listening socket of the client
+*   @return value:  WD_SUCCESS on success, WD_FAILED otherwise
+*   @error:         Returns WD_FAILED if @WD_MAX_LISTEN_FDS fds are shared
+*   @time complex:  O(WD_MAX_LISTEN_FDS) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_status_t WDShareListenFd(int fd);
+
+/*
+*   @desc:          Returns the listening sockets a revived client inherited
+*                   from the watchdog process, in the order they were shared.
+*                   They are shared again with the new watchdog process by
+*                   @StartWD
+*   @params:        @fds: output array
+*                   @max: capacity of @fds
+*   @return value:  Number of fds written to @fds, 0 on a fresh start
+*   @error:         None
+*   @time complex:  O(max) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t WDGetListenFds(int* fds, size_t max);
+
+/*
+*   @desc:          Registers the calling thread for liveness supervision. From
+*                   now on the thread must call @WDKick at least once every
+*                   @threshold * @interval seconds, otherwise the client is
+*                   considered hung and gets revived
+*   @params:        None
+*   @return value:  Slot id of the thread to pass to @WDKick
+*   @error:         Returns -1 if all @WD_MAX_THREADS slots are taken
+*   @time complex:  O(WD_MAX_THREADS) for WC, O(1) for AC
+*   @space complex: O(1) for both AC/WC
+*/
+int WDRegisterThread(void);
+
+/*
+*   @desc:          Stops supervising the thread registered on @slot
+*   @params:        @slot: slot id returned from @WDRegisterThread
+*   @return value:  None
+*   @error:         Undefined behavior if @slot is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WDUnregisterThread(int slot);
+
+/*
+*   @desc:          Reports progress of the thread registered on @slot.
+*                   Costs a single relaxed atomic store
+*   @params:        @slot: slot id returned from @WDRegisterThread
+*   @return value:  None
+*   @error:         Undefined behavior if @slot is invalid
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WDKick(int slot);
+
 #endif  /*__WATCHDOG_H__*/
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef __WD_CTL_H__
+#define __WD_CTL_H__
+
+#include <stddef.h>         /* size_t */
+
+#define CTL_PATH ("/tmp/WatchDog.ctl")
+#define CTL_MAX_REQUEST (128)
+#define CTL_MAX_REPLY (4096)
+#define CTL_POLL_SEC (1)
+
+/*
+*   Caps on what wdctl and WD_CONFIG may set. interval * threshold *
+*   (grace + 2), the longest a peer is given in seconds, stays below INT_MAX
+*/
+#define CTL_MAX_THRESHOLD (1000)
+#define CTL_MAX_INTERVAL (3600)
+#define CTL_MAX_GRACE (100)
+
+/*
+*   Settings both processes of the pair share. The server owns the control
+*   socket and pushes every change to the client over the socket pair, and
+*   both publish them to the environment so revivals start with them too.
+*/
+typedef struct wd_config {
+    size_t threshold;
+    size_t interval;
+    size_t grace_rounds;
+    int log_level;
+} wd_config_t;
+
+/*
+*   @desc:          Parses a decimal count. A sign is refused, strtoul alone
+*                   would take "-1" for ULONG_MAX
+*   @params:        @text: digits only, NUL terminated
+*                   @value: output, left as is on failure
+*   @return value:  0 on success, -1 otherwise
+*/
+int CtlParseValue(const char* text, size_t* value);
+
+/*
+*   @desc:          Checks @config against the CTL_MAX_ caps. Threshold and
+*                   interval must be positive, the log level a log_level_t
+*   @return value:  0 if @config is in bounds, -1 otherwise
+*/
+int CtlCheckConfig(const wd_config_t* config);
+
+/*
+*   @desc:          Server side. Binds the control socket at @path, replacing
+*                   the one a dead watchdog left behind
+*   @params:        @path: socket path, usually CTL_PATH
+*   @return value:  The nonblocking listening fd, -1 on failure
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int CtlListen(const char* path);
+
+/*
+*   @desc:          Server side. Accepts a pending connection without blocking
+*                   and reads its one line request, waiting for it a few
+*                   milliseconds at most
+*   @params:        @listener: fd returned by @CtlListen
+*                   @request: output, the request without its newline
+*                   @size: capacity of @request
+*   @return value:  The connection to pass to @CtlReply, -1 if none is pending
+*   @error:         None
+*   @time complex:  O(size) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int CtlAccept(int listener, char* request, size_t size);
+
+/*
+*   @desc:          Server side. Sends @reply and closes @conn
+*/
+void CtlReply(int conn, const char* reply);
+
+/*
+*   @desc:          Server side. Closes @listener and removes @path
+*/
+void CtlClose(int listener, const char* path);
+
+/*
+*   @desc:          Sends @request to the watchdog listening at @path and
+*                   waits for its reply
+*   @params:        @path: socket path, usually CTL_PATH
+*                   @request: one line request, without a newline
+*                   @reply: output, NUL terminated
+*                   @size: capacity of @reply
+*   @return value:  0 on success, -1 otherwise
+*   @error:         Fails if nothing listens at @path or no reply came in a
+*                   few seconds
+*   @time complex:  O(size) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int CtlRequest(const char* path, const char* request, char* reply,
+                                                                size_t size);
+
+/*
+*   @desc:          Sends @config to the other side of the socket pair without
+*                   blocking
+*   @params:        @sock: either end of the socket pair made by @StartWD
+*                   @config: config to send
+*   @return value:  0 on success, -1 otherwise
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int CtlSendConfig(int sock, const wd_config_t* config);
+
+/*
+*   @desc:          Receives the configs sent so far without blocking, the
+*                   last one wins
+*   @params:        @sock: either end of the socket pair, -1 is allowed
+*                   @config: output, left as is if nothing was received
+*   @return value:  0 if a config was received, -1 otherwise
+*   @error:         None
+*   @time complex:  O(received) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int CtlReceiveConfig(int sock, wd_config_t* config);
+
+/*
+*   @desc:          Publishes @config to the environment, for the processes
+*                   this one execs or forks next
+*/
+void CtlExportConfig(const wd_config_t* config);
+
+/*
+*   @desc:          Reads the config published by @CtlExportConfig
+*   @params:        @config: output, left as is if nothing was published
+*   @return value:  0 if a config was published, -1 otherwise
+*/
+int CtlImportConfig(wd_config_t* config);
+
+#endif  /*__WD_CTL_H__*/
\ No newline at end of file
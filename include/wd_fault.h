@@ -0,0 +1,55 @@
+#ifndef __WD_FAULT_H__
+#define __WD_FAULT_H__
+
+/*
+*   Fault hooks for test/fault_harness.c. Built with -DWD_FAULT_INJECTION,
+*   each side reads FAULT_ENV_NAME as "side:drop:delay:log_delay:after":
+*
+*   side        FAULT_CLIENT, FAULT_SERVER or FAULT_BOTH, the other side
+*               runs clean
+*   drop        percent of heartbeats never sent, a real-time beat still
+*               takes its sequence number so the peer counts it lost
+*   delay       msec every heartbeat is held back before it's sent
+*   log_delay   msec every log line takes to write, a slow disk
+*   after       msec from startup before any of it starts
+*
+*   Without WD_FAULT_INJECTION the hooks expand to nothing.
+*/
+
+#define FAULT_ENV_NAME ("WD_FAULT")
+#define FAULT_FORMAT ("%d:%u:%u:%u:%u")
+
+typedef enum wd_fault_side {
+    FAULT_CLIENT,
+    FAULT_SERVER,
+    FAULT_BOTH
+} wd_fault_side_t;
+
+#ifdef WD_FAULT_INJECTION
+
+#define WD_FAULT_LOAD(location) FaultLoad(location)
+#define WD_FAULT_DROP_BEAT() FaultDropBeat()
+#define WD_FAULT_DELAY_BEAT() FaultDelayBeat()
+#define WD_FAULT_SLOW_LOG() FaultSlowLog()
+
+#else
+
+#define WD_FAULT_LOAD(location) ((void)0)
+#define WD_FAULT_DROP_BEAT() (0)
+#define WD_FAULT_DELAY_BEAT() ((void)0)
+#define WD_FAULT_SLOW_LOG() ((void)0)
+
+#endif /* WD_FAULT_INJECTION */
+
+/* arms the faults FAULT_ENV_NAME sets for @location, a wd_type_t */
+void FaultLoad(int location);
+
+/* 1 if this heartbeat is to be dropped */
+int FaultDropBeat(void);
+
+void FaultDelayBeat(void);
+
+/* async signal safe, the logger runs in signal handlers */
+void FaultSlowLog(void);
+
+#endif /* __WD_FAULT_H__ */
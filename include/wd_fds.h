@@ -0,0 +1,68 @@
+#ifndef __WD_FDS_H__
+#define __WD_FDS_H__
+
+/*
+*   @desc:          Client side. Connects to a newly started watchdog process
+*                   through @sock and hands it every shared listening fd,
+*                   including the ones inherited from a revival
+*   @params:        @sock: client end of the socket pair made by @StartWD
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(WD_MAX_LISTEN_FDS) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdsConnect(int sock);
+
+/*
+*   @desc:          Server side. Starts holding fds received on @sock
+*   @params:        @sock: server end of the socket pair
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdsServe(int sock);
+
+/*
+*   @desc:          Server side. Receives every fd the client sent so far
+*                   without blocking
+*   @params:        None
+*   @return value:  Number of fds held
+*   @error:         None
+*   @time complex:  O(received) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int FdsReceive(void);
+
+/*
+*   @desc:          Returns this side's end of the socket pair, -1 if there is
+*                   none yet
+*/
+int FdsSocket(void);
+
+/*
+*   @desc:          In process mode. Keeps the shared fds, and the ones
+*                   inherited from the last re-exec, open across the next
+*                   exec of the app
+*   @params:        None
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(WD_MAX_LISTEN_FDS) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdsKeepOnExec(void);
+
+/*
+*   @desc:          Server side, or in process mode after @FdsKeepOnExec.
+*                   Publishes the held fds to the environment
+*                   right before the exec of the revived client, which
+*                   inherits them
+*   @params:        None
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(WD_MAX_LISTEN_FDS) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdsExport(void);
+
+#endif  /*__WD_FDS_H__*/
@@ -0,0 +1,128 @@
+#ifndef __WD_PROC_H__
+#define __WD_PROC_H__
+
+#include <sys/types.h>      /* pid_t */
+
+#define PROC_MAX_TASKS (64)
+
+typedef enum wd_hang {
+    HANG_UNKNOWN,
+    HANG_DEAD,
+    HANG_STOPPED,
+    HANG_IO_WAIT,
+    HANG_STARVED,
+    HANG_SPINNING,
+    HANG_DEADLOCK
+} wd_hang_t;
+
+typedef struct proc_task {
+    pid_t tid;
+    int stat_fd;
+} proc_task_t;
+
+typedef struct wd_proc {
+    pid_t pid;
+    int stat_fd;
+    int task_dir_fd;
+    int statm_fd;
+    int fd_dir_fd;
+    size_t task_count;
+    proc_task_t tasks[PROC_MAX_TASKS];
+    unsigned long cpu_ticks;
+    unsigned long mark_ticks;
+} wd_proc_t;
+
+typedef struct proc_sample {
+    char state;
+    unsigned long cpu_ticks;
+    size_t threads;
+    size_t running;
+    size_t io_wait;
+    size_t stopped;
+} proc_sample_t;
+
+typedef struct proc_resources {
+    size_t rss_kb;
+    size_t fds;
+    unsigned long cpu_ticks;
+    unsigned long now_ticks;
+} proc_resources_t;
+
+/*
+*   @desc:          Opens the /proc files of @pid and keeps them open, so
+*                   sampling later on costs only @pread calls
+*   @params:        @proc: uninitialized proc handle
+*                   @pid: process to watch
+*   @return value:  0 on success, -1 otherwise
+*   @error:         On failure @proc is left closed but safe to sample, every
+*                   sample will fail
+*   @time complex:  O(threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ProcOpen(wd_proc_t* proc, pid_t pid);
+
+/*
+*   @desc:          Closes every fd kept by @proc
+*   @params:        @proc: handle opened with @ProcOpen
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ProcClose(wd_proc_t* proc);
+
+/*
+*   @desc:          Reads the process state and per thread states of @proc
+*                   without allocating. Threads started after the last call
+*                   are picked up through the pre opened task directory
+*   @params:        @proc: handle opened with @ProcOpen
+*                   @sample: output
+*   @return value:  0 on success, -1 if the process is gone
+*   @error:         None
+*   @time complex:  O(threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ProcSample(wd_proc_t* proc, proc_sample_t* sample);
+
+/*
+*   @desc:          Reads the resident memory, open fd count and cpu time of
+*                   @proc without allocating
+*   @params:        @proc: handle opened with @ProcOpen
+*                   @resources: output, @now_ticks is the sampling time in
+*                   clock ticks to turn @cpu_ticks into usage
+*   @return value:  0 on success, -1 if the process is gone
+*   @error:         None
+*   @time complex:  O(fds) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ProcResources(wd_proc_t* proc, proc_resources_t* resources);
+
+/*
+*   @desc:          Records the current cpu time of @proc and the current time
+*                   as the baseline for the next @ProcClassify
+*   @params:        @proc: handle opened with @ProcOpen
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ProcMark(wd_proc_t* proc);
+
+/*
+*   @desc:          Classifies why @proc stopped responding, based on its
+*                   state and the share of cpu it got since @ProcMark. Marks
+*                   a new baseline
+*   @params:        @proc: handle opened with @ProcOpen
+*   @return value:  The hang class
+*   @error:         Returns HANG_UNKNOWN if @proc couldn't be opened
+*   @time complex:  O(threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+wd_hang_t ProcClassify(wd_proc_t* proc);
+
+/*
+*   @desc:          Returns a printable name of @hang
+*/
+const char* ProcHangName(wd_hang_t hang);
+
+#endif  /*__WD_PROC_H__*/
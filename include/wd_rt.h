@@ -0,0 +1,48 @@
+#ifndef __WD_RT_H__
+#define __WD_RT_H__
+
+#include "watchdog.h"   /* wd_rt_t */
+
+#define RT_FAILED_LOCK (1)
+#define RT_FAILED_PRIORITY (2)
+#define RT_FAILED_AFFINITY (4)
+
+/*
+*   @desc:          Reads the real-time settings @WDSetRealtime left in the
+*                   environment
+*   @params:        @rt: output
+*   @return value:  1 if real-time mode was asked for, 0 otherwise
+*   @error:         None
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int RtLoad(wd_rt_t* rt);
+
+/*
+*   @desc:          Hardens the calling thread: locks the memory of the
+*                   process, faults in a stack reserve, and moves the thread
+*                   to SCHED_FIFO at @rt->priority on @rt->cpu. Every step
+*                   is tried even if an earlier one failed
+*   @params:        @rt: settings from @RtLoad
+*                   @lock_future: also lock pages mapped from now on. Off in
+*                   the app, whose later allocations aren't ours to pin
+*   @return value:  RT_FAILED_* bits of the steps that failed, 0 if none
+*   @error:         A step fails without CAP_IPC_LOCK, CAP_SYS_NICE or high
+*                   enough RLIMIT_MEMLOCK and RLIMIT_RTPRIO
+*   @time complex:  O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int RtEnter(const wd_rt_t* rt, int lock_future);
+
+/*
+*   @desc:          From @RtArm to @RtDisarm, any malloc, calloc, realloc
+*                   or free by the calling thread aborts with a message on
+*                   stderr. Only built with -DWD_RT_MALLOC_CHECK, which
+*                   interposes the allocator of the whole process, otherwise
+*                   both do nothing
+*/
+void RtArm(void);
+
+void RtDisarm(void);
+
+#endif /* __WD_RT_H__ */
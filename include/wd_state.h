@@ -0,0 +1,19 @@
+#ifndef __WD_STATE_H__
+#define __WD_STATE_H__
+
+#define STATE_NAME_PREFIX ("/WatchDog.")
+#define STATE_MAGIC (0x57445354UL)
+#define STATE_HEADER_SIZE (64)
+
+/*
+*   @desc:          Unmaps and unlinks every state region attached by this
+*                   process, a clean stop must not leave warm state behind
+*   @params:        None
+*   @return value:  None
+*   @error:         None
+*   @time complex:  O(WD_MAX_STATE_REGIONS) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void StateDiscardAll(void);
+
+#endif  /*__WD_STATE_H__*/
@@ -0,0 +1,43 @@
+#ifndef __WD_TRACE_H__
+#define __WD_TRACE_H__
+
+/*
+*   Static tracepoints of the "watchdog" provider for perf and bpftrace.
+*   Built with -DWD_USDT (needs the systemtap <sys/sdt.h>), every WD_TRACE
+*   is a USDT probe: one nop in the code plus an ELF note, so a probe costs
+*   nothing until a tracer attaches to it. Without WD_USDT they expand to
+*   nothing and their arguments aren't even evaluated, so arguments must be
+*   cheap and free of side effects.
+*
+*   task_dequeue        uid counter, lane, due time
+*   task_run_start      uid counter, lateness in usec
+*   task_run_end        uid counter, run time in usec, action result
+*   heartbeat_send      role, peer pid, sequence (0 with SIGUSR1)
+*   heartbeat_receive   role, sender pid, sequence, latency in usec
+*                       (the last two are 0 with SIGUSR1)
+*   threshold_reached   role, peer pid, unanswered beats, verdict
+*   revive_start        role, peer pid
+*   revive_end          role, pid of the revived side, backoff in ms
+*
+*   For example:
+*   bpftrace -e 'usdt:./debug/wd.out:watchdog:task_run_end { @[arg0] =
+*                                                        hist(arg1); }'
+*/
+
+#ifdef WD_USDT
+
+#include <sys/sdt.h>
+
+#define WD_TRACE2(name, a, b) DTRACE_PROBE2(watchdog, name, a, b)
+#define WD_TRACE3(name, a, b, c) DTRACE_PROBE3(watchdog, name, a, b, c)
+#define WD_TRACE4(name, a, b, c, d) DTRACE_PROBE4(watchdog, name, a, b, c, d)
+
+#else
+
+#define WD_TRACE2(name, a, b) ((void)0)
+#define WD_TRACE3(name, a, b, c) ((void)0)
+#define WD_TRACE4(name, a, b, c, d) ((void)0)
+
+#endif /* WD_USDT */
+
+#endif /* __WD_TRACE_H__ */
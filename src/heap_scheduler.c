@@ -1,9 +1,33 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>     /* assert */
-#include <stdlib.h>	/* malloc, free */
+#include <stdlib.h>	/* malloc, free, qsort */
+#include <stdatomic.h>	/* atomic_ulong, atomic_size_t, atomic_int */
+#include <time.h>	/* time, clock_gettime */
+#include <unistd.h>	/* pipe, read, write, close */
+#include <fcntl.h>	/* fcntl, open, O_NONBLOCK */
+#include <errno.h>	/* errno, EINTR */
+#include <poll.h>	/* poll */
 
 #include "heap_scheduler.h"	
 #include "task.h"	
 #include "heap_pq.h"		
+#include "typed_ds.h"
+#include "wd_trace.h"
+#include "sched_trace.h"
+
+#define SLOT_CHUNK (1024)
+#define MAX_SLOT_CHUNKS (1024)
+#define NO_SLOT ((size_t)-1)
+#define CANCELLED (1UL)
+#define STATE_OF(gen) ((gen) << 1)
+#define GEN_OF(state) ((state) >> 1)
+#define DEFAULT_COMPACTION (25)
+#define COMPACT_MIN_SIZE (64)
+#define LANES (2)
+#define NORMAL_BUDGET_USEC (100000)
+#define GROUP_QUEUE_CAPACITY (16)
+#define TRACE_BUFFER (512)
 
 typedef enum signal
 {
@@ -12,12 +36,98 @@ typedef enum signal
     CONTINUE = 2
 } signal_t;
 
+/*
+*   @state is the slot generation shifted left once, the low bit marks the
+*   task as cancelled. Only the scheduler thread bumps the generation and
+*   reuses slots, other threads just set the low bit
+*/
+typedef struct sched_slot
+{
+    atomic_ulong state;
+    size_t next_free;
+    task_t* task;
+    sched_priority_t priority;
+    size_t budget_usec;
+    size_t group;
+    size_t group_prev;
+    size_t group_next;
+} sched_slot_t;
+
+/*
+*   The members of a group wait in heaps of their own, one per lane, not in
+*   the lanes. Each lane instead holds an entry per group keyed by the
+*   group's earliest member, so a whole group is paused or shifted without
+*   touching the lane. A shift moves every member by the same delta, which
+*   keeps their own heap in order. Every member is also on the list at
+*   @head, the running one included
+*/
+typedef struct task_group
+{
+    heap_pq_t* members[LANES];
+    unsigned long version[LANES];
+    unsigned long gen;
+    size_t head;
+    size_t next_free;
+    int in_use;
+    int paused;
+} task_group_t;
+
+/*
+*   Entries aren't removed when their group changes, the group's version
+*   moves on instead and older entries are skipped once they reach the top
+*/
+typedef struct group_entry
+{
+    time_t key;
+    size_t group;
+    unsigned long version;
+} group_entry_t;
+
+#define GROUP_ENTRY_LESS(a, b) ((a).key < (b).key)
+
+DEFINE_PQ(GroupQueue, group_entry_t, GROUP_ENTRY_LESS)
+
+/*
+*   @lock guards @buffer, cancels may come from other threads. A full
+*   buffer is written out under the lock, so recording never allocates.
+*   The recorder lives as long as its scheduler, a stopped trace only
+*   clears @recording, so a late cancel never touches freed memory
+*/
+typedef struct sched_recorder
+{
+    int fd;
+    int failed;
+    struct timespec start;
+    size_t used;
+    atomic_flag lock;
+    sched_trace_record_t buffer[TRACE_BUFFER];
+} sched_recorder_t;
 
 struct scheduler
 {
-    heap_pq_t* queue;
+    heap_pq_t* queues[LANES];
     sched_status_t status;
-    signal_t signal;
+    volatile signal_t signal;
+    int wake_pipe[2];
+    task_t* current;
+    sched_slot_t* slots[MAX_SLOT_CHUNKS];
+    size_t slot_chunks;
+    size_t slots_used;
+    size_t free_slot;
+    atomic_size_t tombstones;
+    size_t compaction;
+    size_t overruns;
+    sched_overrun_t overrun_handler;
+    void* overrun_param;
+    sched_clock_t* clock;
+    task_group_t* groups;
+    size_t groups_used;
+    size_t groups_capacity;
+    size_t free_group;
+    size_t grouped;
+    GroupQueue_t group_queues[LANES];
+    sched_recorder_t* recorder;
+    atomic_int recording;
 };
 
 static int CompareFunc(const void* one, const void* other)
@@ -28,6 +138,19 @@ static int CompareFunc(const void* one, const void* other)
     return TaskGetTimeToRun((task_t*)one) - TaskGetTimeToRun((task_t*)other);
 }
 
+static unsigned long TaskKey(const void* task)
+{
+    assert(task);
+
+    return (unsigned long)TaskGetTimeToRun((const task_t*)task);
+}
+
+static heap_pq_t* CreateLane(sched_backend_t backend)
+{
+    return backend == SCHED_RADIX_HEAP ? PQCreateRadix(TaskKey) :
+                                                    PQCreate(CompareFunc);
+}
+
 static int TaskUIDIsSame(const void* task, const void* uid)
 {
     assert(task);
@@ -36,61 +159,851 @@ static int TaskUIDIsSame(const void* task, const void* uid)
     return UIDIsSame(TaskGetUID(task), *(ilrd_uid_t*)uid);
 }
 
+static int IsSameTask(const void* task, const void* other)
+{
+    return task == other;
+}
+
+static sched_slot_t* SlotAt(const scheduler_t* scheduler, size_t slot)
+{
+    return scheduler->slots[slot / SLOT_CHUNK] + slot % SLOT_CHUNK;
+}
+
+static int AddSlotChunk(scheduler_t* scheduler)
+{
+    sched_slot_t* chunk = NULL;
+    size_t i = 0;
+
+    if (scheduler->slot_chunks == MAX_SLOT_CHUNKS)
+    {
+        return 1;
+    }
+
+    chunk = (sched_slot_t*)malloc(SLOT_CHUNK * sizeof(sched_slot_t));
+    if (chunk == NULL)
+    {
+        return 1;
+    }
+
+    for (; i < SLOT_CHUNK; ++i)
+    {
+        atomic_init(&chunk[i].state, 0);
+        chunk[i].task = NULL;
+    }
+    scheduler->slots[scheduler->slot_chunks++] = chunk;
+
+    return 0;
+}
+
+static size_t AcquireSlot(scheduler_t* scheduler)
+{
+    size_t slot = scheduler->free_slot;
+
+    if (slot != NO_SLOT)
+    {
+        scheduler->free_slot = SlotAt(scheduler, slot)->next_free;
+        return slot;
+    }
+
+    slot = scheduler->slots_used;
+    if (slot == scheduler->slot_chunks * SLOT_CHUNK &&
+                                                AddSlotChunk(scheduler) != 0)
+    {
+        return NO_SLOT;
+    }
+
+    ++scheduler->slots_used;
+
+    return slot;
+}
+
+/* bumps the generation so handles of this task stop matching */
+static void ReleaseSlot(scheduler_t* scheduler, size_t slot)
+{
+    sched_slot_t* entry = SlotAt(scheduler, slot);
+    unsigned long state = atomic_load(&entry->state);
+
+    state = atomic_exchange(&entry->state, STATE_OF(GEN_OF(state) + 1));
+    if (state & CANCELLED)
+    {
+        atomic_fetch_sub(&scheduler->tombstones, 1);
+    }
+
+    entry->task = NULL;
+    entry->next_free = scheduler->free_slot;
+    scheduler->free_slot = slot;
+}
+
+static int WriteAll(int fd, const void* data, size_t size)
+{
+    const char* left = (const char*)data;
+    ssize_t written = 0;
+
+    while (size > 0)
+    {
+        written = write(fd, left, size);
+        if (written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return 1;
+        }
+        left += written;
+        size -= (size_t)written;
+    }
+
+    return 0;
+}
+
+static void Flush(sched_recorder_t* recorder)
+{
+    if (WriteAll(recorder->fd, recorder->buffer,
+                        recorder->used * sizeof(sched_trace_record_t)) != 0)
+    {
+        recorder->failed = 1;
+    }
+    recorder->used = 0;
+}
+
+static void Record(const scheduler_t* scheduler, sched_trace_event_t event,
+                        size_t slot, unsigned long value, int lane, int result)
+{
+    sched_recorder_t* recorder = NULL;
+    sched_trace_record_t* record = NULL;
+    struct timespec now;
+
+    if (!atomic_load(&scheduler->recording))
+    {
+        return;
+    }
+
+    recorder = scheduler->recorder;
+    ClockMonotonic(scheduler->clock, &now);
+
+    while (atomic_flag_test_and_set(&recorder->lock))
+    {
+    }
+
+    /* the trace may have stopped since the check above */
+    if (!atomic_load(&scheduler->recording))
+    {
+        atomic_flag_clear(&recorder->lock);
+        return;
+    }
+
+    record = recorder->buffer + recorder->used;
+    record->usec = (unsigned long)((now.tv_sec - recorder->start.tv_sec) *
+                    1000000L + (now.tv_nsec - recorder->start.tv_nsec) / 1000);
+    record->task = (unsigned int)slot;
+    record->value = (unsigned int)value;
+    record->event = (unsigned char)event;
+    record->lane = (unsigned char)lane;
+    record->result = (unsigned char)result;
+    record->reserved = 0;
+
+    if (++recorder->used == TRACE_BUFFER)
+    {
+        Flush(recorder);
+    }
+
+    atomic_flag_clear(&recorder->lock);
+}
+
+static int StopRecording(scheduler_t* scheduler)
+{
+    sched_recorder_t* recorder = scheduler->recorder;
+    int failed = 0;
+
+    while (atomic_flag_test_and_set(&recorder->lock))
+    {
+    }
+
+    Flush(recorder);
+    failed = recorder->failed | close(recorder->fd);
+    atomic_store(&scheduler->recording, 0);
+    atomic_flag_clear(&recorder->lock);
+
+    return failed != 0;
+}
+
+static int IsCancelled(const scheduler_t* scheduler, const task_t* task)
+{
+    return atomic_load(&SlotAt(scheduler, TaskGetSlot(task))->state) &
+                                                                    CANCELLED;
+}
+
+static void Unlink(scheduler_t* scheduler, size_t slot)
+{
+    sched_slot_t* entry = SlotAt(scheduler, slot);
+
+    if (entry->group == NO_SLOT)
+    {
+        return;
+    }
+
+    if (entry->group_prev != NO_SLOT)
+    {
+        SlotAt(scheduler, entry->group_prev)->group_next = entry->group_next;
+    }
+    else
+    {
+        scheduler->groups[entry->group].head = entry->group_next;
+    }
+
+    if (entry->group_next != NO_SLOT)
+    {
+        SlotAt(scheduler, entry->group_next)->group_prev = entry->group_prev;
+    }
+
+    entry->group = NO_SLOT;
+}
+
+static void DropTask(scheduler_t* scheduler, task_t* task)
+{
+    Unlink(scheduler, TaskGetSlot(task));
+    ReleaseSlot(scheduler, TaskGetSlot(task));
+    TaskDestroy(task);
+}
+
+static int DropIfCancelled(const void* task, const void* scheduler)
+{
+    scheduler_t* owner = (scheduler_t*)scheduler;
+
+    if (!IsCancelled(owner, (const task_t*)task))
+    {
+        return 0;
+    }
+
+    DropTask(owner, (task_t*)task);
+
+    return 1;
+}
+
+/* the lane of an ungrouped task, the lane heap of its group otherwise */
+static heap_pq_t* QueueOf(const scheduler_t* scheduler, const task_t* task)
+{
+    const sched_slot_t* entry = SlotAt(scheduler, TaskGetSlot(task));
+
+    return entry->group == NO_SLOT ? scheduler->queues[entry->priority] :
+                    scheduler->groups[entry->group].members[entry->priority];
+}
+
+static task_group_t* GroupAt(const scheduler_t* scheduler,
+                                                        sched_handle_t group)
+{
+    task_group_t* entry = NULL;
+
+    if (group.slot >= scheduler->groups_used)
+    {
+        return NULL;
+    }
+
+    entry = scheduler->groups + group.slot;
+
+    return entry->in_use && entry->gen == group.gen ? entry : NULL;
+}
+
+/*
+*   Keys the lane entry of @group by its earliest member once more. The old
+*   entry stays valid if there's no room for a new one, an entry too early
+*   only makes the group be looked at before it's due
+*/
+static int Regroup(scheduler_t* scheduler, size_t group, int lane)
+{
+    task_group_t* entry = scheduler->groups + group;
+    group_entry_t key;
+
+    if (entry->paused || entry->members[lane] == NULL ||
+                                            PQIsEmpty(entry->members[lane]))
+    {
+        ++entry->version[lane];
+        return 0;
+    }
+
+    key.key = TaskGetTimeToRun(PQPeek(entry->members[lane]));
+    key.group = group;
+    key.version = entry->version[lane] + 1;
+    if (GroupQueueEnqueue(scheduler->group_queues + lane, key) != 0)
+    {
+        return 1;
+    }
+
+    entry->version[lane] = key.version;
+
+    return 0;
+}
+
+static int Enqueue(scheduler_t* scheduler, task_t* task)
+{
+    const sched_slot_t* entry = SlotAt(scheduler, TaskGetSlot(task));
+    heap_pq_t* queue = QueueOf(scheduler, task);
+
+    if (PQEnqueue(queue, task) != 0)
+    {
+        return 1;
+    }
+
+    if (entry->group == NO_SLOT)
+    {
+        return 0;
+    }
+
+    if (Regroup(scheduler, entry->group, entry->priority) != 0)
+    {
+        PQErase(queue, IsSameTask, task);
+        return 1;
+    }
+    ++scheduler->grouped;
+
+    return 0;
+}
+
+static task_t* Dequeue(scheduler_t* scheduler, heap_pq_t* queue)
+{
+    task_t* task = PQDequeue(queue);
+    const sched_slot_t* entry = SlotAt(scheduler, TaskGetSlot(task));
+
+    if (entry->group != NO_SLOT)
+    {
+        --scheduler->grouped;
+        Regroup(scheduler, entry->group, entry->priority);
+    }
+
+    return task;
+}
+
+/* takes a queued task out of its queue, wherever it is in it */
+static void Unqueue(scheduler_t* scheduler, task_t* task)
+{
+    const sched_slot_t* entry = SlotAt(scheduler, TaskGetSlot(task));
+
+    if (PQErase(QueueOf(scheduler, task), IsSameTask, task) != NULL &&
+                                                    entry->group != NO_SLOT)
+    {
+        --scheduler->grouped;
+        Regroup(scheduler, entry->group, entry->priority);
+    }
+}
+
+/* group heaps are keyed live and shifted in place, a radix heap can't be */
+static int AddMembers(task_group_t* group, int lane)
+{
+    if (group->members[lane] == NULL)
+    {
+        group->members[lane] = PQCreate(CompareFunc);
+    }
+
+    return group->members[lane] == NULL;
+}
+
+static void DestroyMembers(task_group_t* group)
+{
+    int lane = 0;
+
+    for (; lane < LANES; ++lane)
+    {
+        if (group->members[lane] != NULL)
+        {
+            PQDestroy(group->members[lane]);
+            group->members[lane] = NULL;
+        }
+    }
+}
+
+static void Link(scheduler_t* scheduler, size_t slot, size_t group)
+{
+    sched_slot_t* entry = SlotAt(scheduler, slot);
+    task_group_t* owner = scheduler->groups + group;
+
+    entry->group = group;
+    entry->group_prev = NO_SLOT;
+    entry->group_next = owner->head;
+    if (owner->head != NO_SLOT)
+    {
+        SlotAt(scheduler, owner->head)->group_prev = slot;
+    }
+    owner->head = slot;
+}
+
+static size_t AcquireGroup(scheduler_t* scheduler)
+{
+    task_group_t* groups = NULL;
+    size_t group = scheduler->free_group;
+
+    if (group != NO_SLOT)
+    {
+        scheduler->free_group = scheduler->groups[group].next_free;
+        return group;
+    }
+
+    if (scheduler->groups_used == scheduler->groups_capacity)
+    {
+        groups = (task_group_t*)realloc(scheduler->groups,
+                (scheduler->groups_capacity * 2 + 1) * sizeof(task_group_t));
+        if (groups == NULL)
+        {
+            return NO_SLOT;
+        }
+
+        scheduler->groups = groups;
+        scheduler->groups_capacity = scheduler->groups_capacity * 2 + 1;
+    }
+
+    group = scheduler->groups_used++;
+    groups = scheduler->groups + group;
+    groups->members[SCHED_CRITICAL] = NULL;
+    groups->members[SCHED_NORMAL] = NULL;
+    groups->version[SCHED_CRITICAL] = 0;
+    groups->version[SCHED_NORMAL] = 0;
+    groups->gen = 0;
+
+    return group;
+}
+
+/* looks for @uid among the queued members of every group */
+static task_t* EraseGrouped(scheduler_t* scheduler, const ilrd_uid_t* uid)
+{
+    heap_pq_t* members = NULL;
+    task_t* task = NULL;
+    size_t i = 0;
+    int lane = 0;
+
+    for (; lane < LANES; ++lane)
+    {
+        for (i = 0; i < scheduler->groups_used; ++i)
+        {
+            members = scheduler->groups[i].members[lane];
+            if (members != NULL &&
+                (task = PQErase(members, TaskUIDIsSame, uid)) != NULL)
+            {
+                --scheduler->grouped;
+                Regroup(scheduler, i, lane);
+                return task;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static size_t QueuedCount(const scheduler_t* scheduler)
+{
+    size_t count = scheduler->grouped;
+    int lane = 0;
+
+    for (; lane < LANES; ++lane)
+    {
+        count += PQSize(scheduler->queues[lane]);
+    }
+
+    return count;
+}
+
+/* drops the stale entries on top, returns the lane's earliest group or NULL */
+static task_group_t* TopGroup(scheduler_t* scheduler, int lane)
+{
+    GroupQueue_t* queue = scheduler->group_queues + lane;
+    const group_entry_t* top = NULL;
+
+    while (!GroupQueueIsEmpty(queue))
+    {
+        top = GroupQueuePeek(queue);
+        if (top->version == scheduler->groups[top->group].version[lane])
+        {
+            return scheduler->groups + top->group;
+        }
+
+        GroupQueueDequeue(queue);
+    }
+
+    return NULL;
+}
+
+/* the queue holding the earliest task of @lane, ungrouped tasks win ties */
+static heap_pq_t* LaneQueue(scheduler_t* scheduler, int lane)
+{
+    heap_pq_t* tasks = scheduler->queues[lane];
+    task_group_t* group = TopGroup(scheduler, lane);
+
+    if (group == NULL)
+    {
+        return PQIsEmpty(tasks) ? NULL : tasks;
+    }
+
+    if (PQIsEmpty(tasks) || GroupQueuePeek(scheduler->group_queues + lane)->key
+                                        < TaskGetTimeToRun(PQPeek(tasks)))
+    {
+        return group->members[lane];
+    }
+
+    return tasks;
+}
+
+static void Compact(scheduler_t* scheduler)
+{
+    size_t size = QueuedCount(scheduler);
+    size_t tombstones = atomic_load(&scheduler->tombstones);
+    task_group_t* group = NULL;
+    size_t removed = 0;
+    size_t i = 0;
+    int lane = 0;
+
+    if (scheduler->compaction == 0 || size < COMPACT_MIN_SIZE ||
+                            tombstones * 100 <= scheduler->compaction * size)
+    {
+        return;
+    }
+
+    for (; lane < LANES; ++lane)
+    {
+        PQEraseAll(scheduler->queues[lane], DropIfCancelled, scheduler);
+
+        for (i = 0; i < scheduler->groups_used; ++i)
+        {
+            group = scheduler->groups + i;
+            if (group->in_use && group->members[lane] != NULL &&
+                    (removed = PQEraseAll(group->members[lane],
+                                            DropIfCancelled, scheduler)) != 0)
+            {
+                scheduler->grouped -= removed;
+                Regroup(scheduler, i, lane);
+            }
+        }
+    }
+}
+
+/*
+*   A due critical task always goes first. Otherwise the earliest task of
+*   either lane goes, critical winning ties, so nothing is run early
+*/
+static heap_pq_t* NextLane(scheduler_t* scheduler)
+{
+    heap_pq_t* critical = LaneQueue(scheduler, SCHED_CRITICAL);
+    heap_pq_t* normal = LaneQueue(scheduler, SCHED_NORMAL);
+    time_t critical_time = 0;
+
+    if (critical == NULL)
+    {
+        return normal;
+    }
+
+    if (normal == NULL)
+    {
+        return critical;
+    }
+
+    critical_time = TaskGetTimeToRun(PQPeek(critical));
+    if (critical_time <= ClockTime(scheduler->clock) ||
+                    critical_time <= TaskGetTimeToRun(PQPeek(normal)))
+    {
+        return critical;
+    }
+
+    return normal;
+}
+
+static void FillInfo(const scheduler_t* scheduler, size_t slot,
+                                                    sched_task_info_t* info)
+{
+    const sched_slot_t* entry = SlotAt(scheduler, slot);
+
+    info->uid = TaskGetUID(entry->task);
+    info->handle.slot = slot;
+    info->handle.gen = GEN_OF(atomic_load(&entry->state));
+    info->action_func = TaskGetAction(entry->task);
+    info->time_to_run = TaskGetTimeToRun(entry->task);
+    info->interval_in_sec = TaskGetInterval(entry->task);
+    info->priority = entry->priority;
+    info->budget_usec = entry->budget_usec;
+    info->is_running = entry->task == scheduler->current;
+    TaskGetStats(entry->task, &info->stats);
+}
+
+static int CompareInfo(const void* one, const void* other)
+{
+    time_t one_time = ((const sched_task_info_t*)one)->time_to_run;
+    time_t other_time = ((const sched_task_info_t*)other)->time_to_run;
+
+    return (one_time > other_time) - (one_time < other_time);
+}
+
+static void Wake(scheduler_t* scheduler)
+{
+    char byte = 0;
+
+    /* a full pipe already holds a wake up */
+    if (write(scheduler->wake_pipe[1], &byte, 1) == -1)
+    {
+        return;
+    }
+}
+
+static int OpenWakePipe(int* wake_pipe)
+{
+    int i = 0;
+
+    if (pipe(wake_pipe) == -1)
+    {
+        return 1;
+    }
+
+    for (; i < 2; ++i)
+    {
+        fcntl(wake_pipe[i], F_SETFL, fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    return 0;
+}
+
+/*
+*   Waits until @time_to_run on the wake pipe instead of sleeping, so a stop
+*   or destroy, even from a signal handler, ends the wait right away. Returns
+*   nonzero if woken before @time_to_run.
+*   Being due is judged by time(), the clock @time_to_run is set from. It may
+*   lag behind CLOCK_REALTIME by a few milliseconds, judging by the latter
+*   would rerun a task before its next @time_to_run moved on
+*/
+static int WaitUntil(scheduler_t* scheduler, time_t time_to_run)
+{
+    struct pollfd wake;
+    struct timespec now;
+    long wait_ms = 0;
+    char drain[16];
+    int ready = 0;
+
+    /* nothing else can happen before a simulated deadline */
+    if (scheduler->clock != NULL)
+    {
+        ClockJumpTo(scheduler->clock, time_to_run);
+        return 0;
+    }
+
+    wake.fd = scheduler->wake_pipe[0];
+    wake.events = POLLIN;
+
+    while (time(NULL) < time_to_run)
+    {
+        clock_gettime(CLOCK_REALTIME, &now);
+        wait_ms = (time_to_run - now.tv_sec) * 1000 - now.tv_nsec / 1000000;
+
+        wake.revents = 0;
+        ready = poll(&wake, 1, wait_ms > 0 ? wait_ms : 1);
+        if (ready != 0)
+        {
+            break;
+        }
+    }
+
+    if (ready == 0)
+    {
+        return 0;
+    }
+
+    while (read(scheduler->wake_pipe[0], drain, sizeof(drain)) > 0)
+    {
+    }
+
+    return 1;
+}
+
+static void CheckBudget(scheduler_t* scheduler, task_t* task)
+{
+    size_t budget = SlotAt(scheduler, TaskGetSlot(task))->budget_usec;
+    size_t run_usec = TaskGetRunTime(task);
+
+    if (budget == 0 || run_usec <= budget)
+    {
+        return;
+    }
+
+    ++scheduler->overruns;
+    if (scheduler->overrun_handler != NULL)
+    {
+        scheduler->overrun_handler(TaskGetUID(task), run_usec,
+                                                    scheduler->overrun_param);
+    }
+}
+
 scheduler_t* SchedulerCreate(void)
 {
-    scheduler_t* scheduler = (scheduler_t*)malloc(sizeof(scheduler_t));
-    
+    return SchedulerCreateBackend(SCHED_BINARY_HEAP);
+}
+
+scheduler_t* SchedulerCreateBackend(sched_backend_t backend)
+{
+    scheduler_t* scheduler = NULL;
+    assert(backend == SCHED_BINARY_HEAP || backend == SCHED_RADIX_HEAP);
+
+    scheduler = (scheduler_t*)malloc(sizeof(scheduler_t));
     if (scheduler == NULL)
     {	
         return NULL;
     }
 	
-    scheduler->queue = PQCreate(CompareFunc);
-    if (scheduler->queue == NULL)
+    scheduler->queues[SCHED_CRITICAL] = CreateLane(backend);
+    if (scheduler->queues[SCHED_CRITICAL] == NULL)
     {
         free(scheduler);
       	return NULL;
     }
+
+    scheduler->queues[SCHED_NORMAL] = CreateLane(backend);
+    if (scheduler->queues[SCHED_NORMAL] == NULL)
+    {
+        PQDestroy(scheduler->queues[SCHED_CRITICAL]);
+        free(scheduler);
+        return NULL;
+    }
+
+    if (OpenWakePipe(scheduler->wake_pipe) != 0)
+    {
+        PQDestroy(scheduler->queues[SCHED_NORMAL]);
+        PQDestroy(scheduler->queues[SCHED_CRITICAL]);
+        free(scheduler);
+        return NULL;
+    }
+
+    if (GroupQueueCreate(scheduler->group_queues + SCHED_CRITICAL,
+                                                    GROUP_QUEUE_CAPACITY) ||
+        GroupQueueCreate(scheduler->group_queues + SCHED_NORMAL,
+                                                    GROUP_QUEUE_CAPACITY))
+    {
+        GroupQueueDestroy(scheduler->group_queues + SCHED_CRITICAL);
+        close(scheduler->wake_pipe[0]);
+        close(scheduler->wake_pipe[1]);
+        PQDestroy(scheduler->queues[SCHED_NORMAL]);
+        PQDestroy(scheduler->queues[SCHED_CRITICAL]);
+        free(scheduler);
+        return NULL;
+    }
 	
     scheduler->status = SCHED_STOPPED;
     scheduler->signal = CONTINUE;
+    scheduler->current = NULL;
+    scheduler->slot_chunks = 0;
+    scheduler->slots_used = 0;
+    scheduler->free_slot = NO_SLOT;
+    scheduler->compaction = DEFAULT_COMPACTION;
+    scheduler->overruns = 0;
+    scheduler->overrun_handler = NULL;
+    scheduler->overrun_param = NULL;
+    scheduler->clock = NULL;
+    scheduler->groups = NULL;
+    scheduler->groups_used = 0;
+    scheduler->groups_capacity = 0;
+    scheduler->free_group = NO_SLOT;
+    scheduler->grouped = 0;
+    scheduler->recorder = NULL;
+    atomic_init(&scheduler->recording, 0);
+    atomic_init(&scheduler->tombstones, 0);
 	
     return scheduler;
 }
 
 void SchedulerDestroy(scheduler_t* scheduler)
 {
+    size_t i = 0;
+
     assert(scheduler);
     
     if (scheduler->status == SCHED_RUNNING)
     {
         scheduler->signal = DESTROY;
+        Wake(scheduler);
         return;
     }
+    SchedulerRecord(scheduler, NULL);
+    free(scheduler->recorder);
     SchedulerClear(scheduler);
-    PQDestroy(scheduler->queue);
+    PQDestroy(scheduler->queues[SCHED_CRITICAL]);
+    PQDestroy(scheduler->queues[SCHED_NORMAL]);
+    close(scheduler->wake_pipe[0]);
+    close(scheduler->wake_pipe[1]);
+
+    for (; i < scheduler->groups_used; ++i)
+    {
+        DestroyMembers(scheduler->groups + i);
+    }
+    free(scheduler->groups);
+    GroupQueueDestroy(scheduler->group_queues + SCHED_CRITICAL);
+    GroupQueueDestroy(scheduler->group_queues + SCHED_NORMAL);
+
+    i = 0;
+
+    for (; i < scheduler->slot_chunks; ++i)
+    {
+        free(scheduler->slots[i]);
+    }
     free(scheduler);
 }
 
 ilrd_uid_t SchedulerAdd(scheduler_t* scheduler,
 			    int (*action_func)(void* params), void* params,
 			    size_t interval_in_sec)
+{
+    return SchedulerAddEx(scheduler, action_func, params, interval_in_sec,
+                                                    SCHED_NORMAL, NULL, NULL);
+}
+
+ilrd_uid_t SchedulerAddEx(scheduler_t* scheduler,
+			    int (*action_func)(void* params), void* params,
+			    size_t interval_in_sec, sched_priority_t priority,
+			    const sched_handle_t* group, sched_handle_t* handle)
 {
     task_t* task = NULL;
+    task_group_t* owner = NULL;
+    sched_slot_t* entry = NULL;
+    size_t slot = 0;
     assert(scheduler);
     assert(action_func);
+    assert(priority == SCHED_CRITICAL || priority == SCHED_NORMAL);
+
+    if (group != NULL && ((owner = GroupAt(scheduler, *group)) == NULL ||
+                                    AddMembers(owner, priority) != 0))
+    {
+        return bad_uid;
+    }
 	
     task = TaskCreate(action_func, params, interval_in_sec);
     if (task == NULL)
     {
       	return bad_uid;
     }
+    TaskSetClock(task, scheduler->clock);
 	
-    if (PQEnqueue(scheduler->queue, task) != 0)
+    slot = AcquireSlot(scheduler);
+    if (slot == NO_SLOT)
+    {
+        TaskDestroy(task);
+        return bad_uid;
+    }
+    TaskSetSlot(task, slot);
+
+    entry = SlotAt(scheduler, slot);
+    entry->task = task;
+    entry->priority = priority;
+    entry->budget_usec = priority == SCHED_NORMAL ? NORMAL_BUDGET_USEC : 0;
+    entry->group = NO_SLOT;
+    if (owner != NULL)
+    {
+        Link(scheduler, slot, group->slot);
+    }
+
+    if (Enqueue(scheduler, task) != 0)
     {
-      	TaskDestroy(task);
+      	DropTask(scheduler, task);
       	return bad_uid;
     }
+
+    if (handle != NULL)
+    {
+        handle->slot = slot;
+        handle->gen = GEN_OF(atomic_load(&entry->state));
+    }
+    Record(scheduler, TRACE_ADD, slot, interval_in_sec, priority, 0);
 	
     return TaskGetUID(task);
 }
@@ -98,34 +1011,459 @@ ilrd_uid_t SchedulerAdd(scheduler_t* scheduler,
 int SchedulerRemove(scheduler_t* scheduler, ilrd_uid_t identifier)
 {
     task_t* task = NULL;
+    sched_handle_t handle;
+    int was_cancelled = 0;
     assert(scheduler);
 	
-    task = PQErase(scheduler->queue, TaskUIDIsSame, &identifier); 
+    task = scheduler->current;
+    if (task != NULL && UIDIsSame(TaskGetUID(task), identifier))
+    {
+        handle.slot = TaskGetSlot(task);
+        handle.gen = GEN_OF(atomic_load(&SlotAt(scheduler,
+                                                    handle.slot)->state));
+
+        return SchedulerCancel(scheduler, handle);
+    }
+
+    task = PQErase(scheduler->queues[SCHED_CRITICAL], TaskUIDIsSame,
+                                                                &identifier);
+    if (task == NULL)
+    {
+        task = PQErase(scheduler->queues[SCHED_NORMAL], TaskUIDIsSame,
+                                                                &identifier);
+    }
+    if (task == NULL)
+    {
+        task = EraseGrouped(scheduler, &identifier);
+    }
     if (task == NULL)
     {
       	return 1;
     }
 	
-    TaskDestroy(task);
+    was_cancelled = IsCancelled(scheduler, task);
+    if (!was_cancelled)
+    {
+        Record(scheduler, TRACE_REMOVE, TaskGetSlot(task), 0,
+                        SlotAt(scheduler, TaskGetSlot(task))->priority, 0);
+    }
+    DropTask(scheduler, task);
+
+    return was_cancelled;
+}
+
+int SchedulerCancel(scheduler_t* scheduler, sched_handle_t handle)
+{
+    unsigned long expected = STATE_OF(handle.gen);
+    assert(scheduler);
+
+    if (!atomic_compare_exchange_strong(&SlotAt(scheduler, handle.slot)->state,
+                                            &expected, expected | CANCELLED))
+    {
+        return 1;
+    }
+
+    atomic_fetch_add(&scheduler->tombstones, 1);
+    Record(scheduler, TRACE_REMOVE, handle.slot, 0,
+                            SlotAt(scheduler, handle.slot)->priority, 0);
+    Wake(scheduler);
 	
     return 0;
 }
 
+int SchedulerGroupCreate(scheduler_t* scheduler, sched_handle_t* group)
+{
+    task_group_t* entry = NULL;
+    size_t slot = 0;
+    assert(scheduler);
+    assert(group);
+
+    slot = AcquireGroup(scheduler);
+    if (slot == NO_SLOT)
+    {
+        return 1;
+    }
+
+    entry = scheduler->groups + slot;
+    entry->head = NO_SLOT;
+    entry->in_use = 1;
+    entry->paused = 0;
+
+    group->slot = slot;
+    group->gen = entry->gen;
+
+    return 0;
+}
+
+int SchedulerGroupCancel(scheduler_t* scheduler, sched_handle_t group)
+{
+    task_group_t* entry = NULL;
+    sched_slot_t* member = NULL;
+    heap_pq_t* members = NULL;
+    size_t slot = 0;
+    int lane = 0;
+    assert(scheduler);
+
+    entry = GroupAt(scheduler, group);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    /* the running member isn't queued, TaskHandler drops it once it returns */
+    for (slot = entry->head; slot != NO_SLOT; slot = member->group_next)
+    {
+        member = SlotAt(scheduler, slot);
+        member->group = NO_SLOT;
+        if (!(atomic_fetch_or(&member->state, CANCELLED) & CANCELLED))
+        {
+            atomic_fetch_add(&scheduler->tombstones, 1);
+            Record(scheduler, TRACE_REMOVE, slot, 0, member->priority, 0);
+        }
+    }
+    entry->head = NO_SLOT;
+
+    for (; lane < LANES; ++lane)
+    {
+        members = entry->members[lane];
+        while (members != NULL && !PQIsEmpty(members))
+        {
+            --scheduler->grouped;
+            DropTask(scheduler, PQDequeue(members));
+        }
+        ++entry->version[lane];
+    }
+
+    DestroyMembers(entry);
+    entry->in_use = 0;
+    ++entry->gen;
+    entry->next_free = scheduler->free_group;
+    scheduler->free_group = group.slot;
+
+    return 0;
+}
+
+int SchedulerGroupPause(scheduler_t* scheduler, sched_handle_t group)
+{
+    task_group_t* entry = NULL;
+    assert(scheduler);
+
+    entry = GroupAt(scheduler, group);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    entry->paused = 1;
+    ++entry->version[SCHED_CRITICAL];
+    ++entry->version[SCHED_NORMAL];
+
+    return 0;
+}
+
+int SchedulerGroupResume(scheduler_t* scheduler, sched_handle_t group)
+{
+    task_group_t* entry = NULL;
+    assert(scheduler);
+
+    entry = GroupAt(scheduler, group);
+    if (entry == NULL || !entry->paused)
+    {
+        return entry == NULL;
+    }
+
+    entry->paused = 0;
+
+    return Regroup(scheduler, group.slot, SCHED_CRITICAL) ||
+                                Regroup(scheduler, group.slot, SCHED_NORMAL);
+}
+
+int SchedulerGroupShift(scheduler_t* scheduler, sched_handle_t group,
+                                                            long delta_sec)
+{
+    task_group_t* entry = NULL;
+    sched_slot_t* member = NULL;
+    size_t slot = 0;
+    assert(scheduler);
+
+    entry = GroupAt(scheduler, group);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    /* the same delta for every member keeps their heaps in order */
+    for (slot = entry->head; slot != NO_SLOT; slot = member->group_next)
+    {
+        member = SlotAt(scheduler, slot);
+        if (member->task != scheduler->current)
+        {
+            TaskShift(member->task, delta_sec);
+        }
+    }
+
+    return Regroup(scheduler, group.slot, SCHED_CRITICAL) ||
+                                Regroup(scheduler, group.slot, SCHED_NORMAL);
+}
+
+void SchedulerSetCompaction(scheduler_t* scheduler, size_t percent)
+{
+    assert(scheduler);
+
+    scheduler->compaction = percent;
+}
+
+int SchedulerSetBudget(scheduler_t* scheduler, sched_handle_t handle,
+                                                            size_t budget_usec)
+{
+    sched_slot_t* entry = NULL;
+    assert(scheduler);
+
+    entry = SlotAt(scheduler, handle.slot);
+    if (atomic_load(&entry->state) != STATE_OF(handle.gen))
+    {
+        return 1;
+    }
+
+    entry->budget_usec = budget_usec;
+
+    return 0;
+}
+
+int SchedulerReschedule(scheduler_t* scheduler, sched_handle_t handle,
+                                                        size_t interval_in_sec)
+{
+    sched_slot_t* entry = NULL;
+    assert(scheduler);
+
+    entry = SlotAt(scheduler, handle.slot);
+    if (atomic_load(&entry->state) != STATE_OF(handle.gen))
+    {
+        return 1;
+    }
+
+    /* TaskHandler requeues the running task by its new interval */
+    if (entry->task == scheduler->current)
+    {
+        TaskSetInterval(entry->task, interval_in_sec);
+        return 0;
+    }
+
+    Unqueue(scheduler, entry->task);
+    TaskSetInterval(entry->task, interval_in_sec);
+    if (Enqueue(scheduler, entry->task) != 0)
+    {
+        DropTask(scheduler, entry->task);
+        return 1;
+    }
+
+    return 0;
+}
+
+int SchedulerRestoreTask(scheduler_t* scheduler, sched_handle_t handle,
+                                    const sched_task_info_t* saved)
+{
+    sched_slot_t* entry = NULL;
+    assert(scheduler);
+    assert(saved);
+
+    entry = SlotAt(scheduler, handle.slot);
+    if (atomic_load(&entry->state) != STATE_OF(handle.gen) ||
+                                            entry->task == scheduler->current)
+    {
+        return 1;
+    }
+
+    Unqueue(scheduler, entry->task);
+    TaskSetInterval(entry->task, saved->interval_in_sec);
+    TaskRestore(entry->task, saved->time_to_run, &saved->stats);
+    entry->budget_usec = saved->budget_usec;
+    if (Enqueue(scheduler, entry->task) != 0)
+    {
+        DropTask(scheduler, entry->task);
+        return 1;
+    }
+
+    return 0;
+}
+
+int SchedulerReserve(scheduler_t* scheduler, size_t tasks)
+{
+    assert(scheduler);
+
+    while (scheduler->slot_chunks * SLOT_CHUNK < tasks)
+    {
+        if (AddSlotChunk(scheduler) != 0)
+        {
+            return 1;
+        }
+    }
+
+    return PQReserve(scheduler->queues[SCHED_CRITICAL], tasks) ||
+                        PQReserve(scheduler->queues[SCHED_NORMAL], tasks);
+}
+
+void SchedulerSetClock(scheduler_t* scheduler, sched_clock_t* clock)
+{
+    assert(scheduler);
+    assert(SchedulerIsEmpty(scheduler));
+
+    scheduler->clock = clock;
+}
+
+int SchedulerRecord(scheduler_t* scheduler, const char* path)
+{
+    sched_recorder_t* recorder = scheduler->recorder;
+    sched_trace_header_t header;
+    int failed = 0;
+    int fd = -1;
+    assert(scheduler);
+
+    if (atomic_load(&scheduler->recording))
+    {
+        failed = StopRecording(scheduler);
+    }
+    if (path == NULL)
+    {
+        return failed;
+    }
+
+    if (recorder == NULL)
+    {
+        recorder = (sched_recorder_t*)malloc(sizeof(sched_recorder_t));
+        if (recorder == NULL)
+        {
+            return 1;
+        }
+        atomic_flag_clear(&recorder->lock);
+        scheduler->recorder = recorder;
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        return 1;
+    }
+
+    header.magic = SCHED_TRACE_MAGIC;
+    header.version = SCHED_TRACE_VERSION;
+    header.record_size = sizeof(sched_trace_record_t);
+    if (WriteAll(fd, &header, sizeof(header)) != 0)
+    {
+        close(fd);
+        return 1;
+    }
+
+    /* nothing records until @recording is set, after the fields */
+    recorder->fd = fd;
+    recorder->failed = 0;
+    recorder->used = 0;
+    ClockMonotonic(scheduler->clock, &recorder->start);
+    atomic_store(&scheduler->recording, 1);
+
+    return 0;
+}
+
+void SchedulerSetOverrunHandler(scheduler_t* scheduler,
+                                    sched_overrun_t handler, void* param)
+{
+    assert(scheduler);
+
+    scheduler->overrun_handler = handler;
+    scheduler->overrun_param = param;
+}
+
+size_t SchedulerOverruns(const scheduler_t* scheduler)
+{
+    assert(scheduler);
+
+    return scheduler->overruns;
+}
+
+size_t SchedulerForEach(const scheduler_t* scheduler, sched_visit_t visit,
+                                                                void* param)
+{
+    const sched_slot_t* entry = NULL;
+    sched_task_info_t info;
+    size_t visited = 0;
+    size_t slot = 0;
+    assert(scheduler);
+    assert(visit);
+
+    for (; slot < scheduler->slots_used; ++slot)
+    {
+        entry = SlotAt(scheduler, slot);
+        if (entry->task == NULL || (atomic_load(&entry->state) & CANCELLED))
+        {
+            continue;
+        }
+
+        FillInfo(scheduler, slot, &info);
+        ++visited;
+        if (visit(&info, param) != 0)
+        {
+            break;
+        }
+    }
+
+    return visited;
+}
+
+size_t SchedulerSnapshot(const scheduler_t* scheduler,
+                                        sched_task_info_t* infos, size_t max)
+{
+    const sched_slot_t* entry = NULL;
+    size_t count = 0;
+    size_t slot = 0;
+    assert(scheduler);
+    assert(infos || max == 0);
+
+    for (; slot < scheduler->slots_used && count < max; ++slot)
+    {
+        entry = SlotAt(scheduler, slot);
+        if (entry->task != NULL && !(atomic_load(&entry->state) & CANCELLED))
+        {
+            FillInfo(scheduler, slot, infos + count);
+            ++count;
+        }
+    }
+
+    qsort(infos, count, sizeof(sched_task_info_t), CompareInfo);
+
+    return count;
+}
+
 static int TaskHandler(scheduler_t* scheduler, task_t* task)
 {
+    int result = 0;
     assert(scheduler);
     assert(task);
+
+    /* another thread may have cancelled it while the loop waited */
+    if (IsCancelled(scheduler, task))
+    {
+        DropTask(scheduler, task);
+        return SCHED_SUCCESS;
+    }
 	
-    if (TaskRun(task) != 0)
+    scheduler->current = task;
+    result = TaskRun(task);
+    scheduler->current = NULL;
+
+    CheckBudget(scheduler, task);
+    Record(scheduler, TRACE_RUN, TaskGetSlot(task), TaskGetRunTime(task),
+                SlotAt(scheduler, TaskGetSlot(task))->priority, result != 0);
+
+    if (result != 0 || IsCancelled(scheduler, task))
     {
-      	TaskDestroy(task);
+      	DropTask(scheduler, task);
     }
     else
     {
-      	TaskSetTimeToRun(task, time(NULL));
-      	if (PQEnqueue(scheduler->queue, task) != 0)
+      	TaskSetTimeToRun(task);
+      	if (Enqueue(scheduler, task) != 0)
       	{
-    	    TaskDestroy(task);
+    	    DropTask(scheduler, task);
 	        return SCHED_ERROR;
 	    }
     }
@@ -136,18 +1474,41 @@ static int TaskHandler(scheduler_t* scheduler, task_t* task)
 sched_status_t SchedulerRun(scheduler_t* scheduler)
 {
     task_t* task = NULL;
+    heap_pq_t* lane = NULL;
     assert(scheduler);
-    
+
     if (scheduler->status == SCHED_RUNNING)
     {
         return SCHED_RUNNING;
     }
-    
+
+    /* a stop that came in before the run is kept, not lost */
     scheduler->status = SCHED_RUNNING;
-    scheduler->signal = CONTINUE;
-    while (scheduler->signal == CONTINUE && !SchedulerIsEmpty(scheduler))
+    while (scheduler->signal == CONTINUE)
     {
-        task = PQDequeue(scheduler->queue);
+        Compact(scheduler);
+        lane = NextLane(scheduler);
+        if (lane == NULL)
+        {
+            break;
+        }
+
+        task = PQPeek(lane);
+        if (IsCancelled(scheduler, task))
+        {
+            DropTask(scheduler, Dequeue(scheduler, lane));
+            continue;
+        }
+
+        if (WaitUntil(scheduler, TaskGetTimeToRun(task)) != 0)
+        {
+            continue;
+        }
+
+        task = Dequeue(scheduler, lane);
+        WD_TRACE3(task_dequeue, TaskGetUID(task).counter,
+                    SlotAt(scheduler, TaskGetSlot(task))->priority,
+                    TaskGetTimeToRun(task));
         if (TaskHandler(scheduler, task) != 0)
         {
             return SCHED_ERROR;
@@ -162,11 +1523,14 @@ sched_status_t SchedulerRun(scheduler_t* scheduler)
             return SCHED_DESTROYED;
         case STOP:
             scheduler->status = SCHED_STOPPED;
+            Record(scheduler, TRACE_STOP, 0, 0, 0, 0);
             break;
         default:
             scheduler->status = SCHED_SUCCESS;
             break;
     }
+    scheduler->signal = CONTINUE;
+
     return scheduler->status;
 }
 
@@ -177,29 +1541,57 @@ void SchedulerStop(scheduler_t* scheduler)
     if (scheduler->signal != DESTROY)
     {
         scheduler->signal = STOP;
+        Wake(scheduler);
     }
 }
 
 size_t SchedulerSize(const scheduler_t* scheduler)
 {
+    size_t size = 0;
+    size_t tombstones = 0;
     assert(scheduler);
     
-    return PQSize(scheduler->queue);
+    size = QueuedCount(scheduler);
+    tombstones = atomic_load(&scheduler->tombstones);
+
+    /* a cancelled running task is counted as a tombstone but isn't queued */
+    if (scheduler->current != NULL &&
+                                IsCancelled(scheduler, scheduler->current))
+    {
+        ++size;
+    }
+
+    return size > tombstones ? size - tombstones : 0;
 }
 
 int SchedulerIsEmpty(const scheduler_t* scheduler)
 {
     assert(scheduler);
     
-    return PQIsEmpty(scheduler->queue);
+    return SchedulerSize(scheduler) == 0;
 }
 
 void SchedulerClear(scheduler_t* scheduler)
 {
+    heap_pq_t* members = NULL;
+    size_t i = 0;
+    int lane = 0;
     assert(scheduler);
-	
-    while (!SchedulerIsEmpty(scheduler))
+
+    for (; lane < LANES; ++lane)
     {
-        TaskDestroy(PQDequeue(scheduler->queue));
+        while (!PQIsEmpty(scheduler->queues[lane]))
+        {
+            DropTask(scheduler, PQDequeue(scheduler->queues[lane]));
+        }
+
+        for (i = 0; i < scheduler->groups_used; ++i)
+        {
+            members = scheduler->groups[i].members[lane];
+            while (members != NULL && !PQIsEmpty(members))
+            {
+                DropTask(scheduler, Dequeue(scheduler, members));
+            }
+        }
     }
 }
@@ -1,163 +1,1402 @@
 #define _POSIX_C_SOURCE 200112L
 
-#include <unistd.h>     /* execvp */
-#include <stdlib.h>     /* malloc, free, atoi, getenv */
-#include <pthread.h>    /* pthread_exit */
+#include <unistd.h>     /* execvp, pipe, read, write */
+#include <stdlib.h>     /* malloc, free, atoi, getenv, setenv, rand_r */
+#include <pthread.h>    /* pthread_exit, pthread_mutex_t */
 #include <signal.h>     /* SIGUSR1, SIGUSR2, kill */
 #include <semaphore.h>  /* sem_t, sem_open, sem_post, sem_close, sem_unlink */
-#include <fcntl.h>            /* O_RDWR */
+                        /* sem_init, sem_wait, sem_destroy */
+#include <fcntl.h>            /* O_RDWR, O_NONBLOCK */
 #include <bits/sigaction.h>   /* sigaction */
 #include <sys/wait.h>   /* waitpid */
 #include <stdatomic.h>     /* atomic_uint */
+#include <assert.h>     /* assert */
+#include <stdio.h>      /* sprintf, sscanf */
+#include <string.h>     /* memset, strcmp, strcpy */
+#include <time.h>       /* time, clock_gettime */
+#include <limits.h>     /* CHAR_BIT */
+#include <poll.h>       /* poll */
 
 #include "inner_watchdog.h"
 #include "watchdog.h"
+#include "wd_proc.h"
+#include "wd_fds.h"
+#include "wd_ctl.h"
+#include "sched_snapshot.h"
+#include "logger.h"
+#include "wd_trace.h"
+#include "wd_rt.h"
+#include "wd_fault.h"
+
+#define STATUS_MAX_TASKS (16)
+#define HEARTBEAT_RT_SIGNAL (SIGRTMIN)
+#define BEAT_BITS (sizeof(void*) * CHAR_BIT / 2)
+#define BEAT_MASK ((1UL << BEAT_BITS) - 1)
+
+#ifndef NDEBUG
+
+#define LOGGER_NAME ("WatchDogLogger.txt")
+
+#endif
+
+typedef struct watch_dog
+{
+    size_t threshold;
+    size_t interval;
+    int argc;
+    wd_type_t location;
+    scheduler_t* scheduler;
+    atomic_uint counter;
+    wd_proc_t peer;
+    size_t grace_rounds;
+    int escalated;
+    wd_budget_t budget;
+    size_t breaches;
+    proc_resources_t last_sample;
+    size_t max_grace;
+    int log_level;
+    int control;
+    int sampling;
+    int has_sampler;
+    sched_handle_t heartbeat;
+    sched_handle_t timer;
+    sched_handle_t sampler;
+    sched_snapshot_t* snapshot;
+    int transport;
+    unsigned long send_seq;
+    wd_rt_t rt;
+    int rt_failed;
+} watch_dog_t;
+
+typedef struct restart_history
+{
+    size_t restarts;
+    size_t window_restarts;
+    long window_start;
+    long last_restart;
+    size_t backoff_ms;
+    int degraded;
+} restart_history_t;
+
+typedef enum wd_verdict {
+    VERDICT_WAIT,
+    VERDICT_ESCALATE,
+    VERDICT_REVIVE
+} wd_verdict_t;
+
+/* a slot is claimed first and only active once its count is reset */
+typedef enum slot_state {
+    SLOT_FREE,
+    SLOT_CLAIMING,
+    SLOT_ACTIVE
+} slot_state_t;
+
+typedef struct thread_slot
+{
+    atomic_int in_use;
+    atomic_uint missed;
+} thread_slot_t;
+
+/* written from the real-time signal handler, read by WDGetMetrics */
+typedef struct beat_stats
+{
+    atomic_ulong seq;
+    atomic_ulong received;
+    atomic_ulong lost;
+    atomic_ulong unsent;
+    atomic_ulong last_latency_us;
+    atomic_ulong max_latency_us;
+    atomic_ulong total_latency_us;
+} beat_stats_t;
+
+typedef struct in_process
+{
+    wd_action_t action;
+    wd_hook_t hook;
+    void* param;
+    sem_t ready;
+} in_process_t;
+
+watch_dog_t watch_dog;
+sem_t* inner_sem;
+pid_t other_pid;
+
+static volatile sig_atomic_t stop_requested;
+static int stop_pipe[2] = {-1, -1};
+static pthread_mutex_t revive_lock = PTHREAD_MUTEX_INITIALIZER;
+static in_process_t in_process;
+static beat_stats_t beats;
+static restart_history_t server_history;
+static thread_slot_t thread_slots[WD_MAX_THREADS];
+static atomic_int slots_high_mark;
+
+static const char* snapshot_paths[] = {SNAPSHOT_PATH_CLIENT,
+                                SNAPSHOT_PATH_SERVER, SNAPSHOT_PATH_INPROC};
+
+/**********************Static Functions Implementation*************************/
+
+/* ends a revival backoff early, async signal safe */
+static void WakeBackoff(void)
+{
+    char byte = 0;
+
+    /* a full pipe already holds a wake up */
+    if(-1 != stop_pipe[1] && -1 == write(stop_pipe[1], &byte, 1))
+    {
+        return;
+    }
+}
+
+static void SignalOneHandler(int sig)
+{
+    (void)sig;
+    atomic_store(&watch_dog.counter, 0);
+    WD_TRACE4(heartbeat_receive, watch_dog.location, other_pid, 0, 0);
+
+#ifndef NDEBUG
+    UploadVerbose(LOGGER_NAME, "Received Signal 1", watch_dog.location);
+#endif
+}
+
+static unsigned long NowUsec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/*
+*   A real-time beat carries its sequence number in the high half of
+*   @sival_ptr and the send time in microseconds in the low half, both
+*   wrapping. A gap in the sequence is beats that never arrived, a sequence
+*   that goes back is a new peer starting over.
+*   A beat only proves the peer was alive when it was sent, so the intervals
+*   since then stay on the counter. So do the lost beats before it once
+*   they fill a threshold, one beat through in threshold + 1 is no better
+*   than silence
+*/
+static void RtSignalHandler(int sig, siginfo_t* info, void* context)
+{
+    unsigned long value = (unsigned long)info->si_value.sival_ptr;
+    unsigned long seq = value >> BEAT_BITS;
+    unsigned long latency = (NowUsec() - value) & BEAT_MASK;
+    unsigned long last = atomic_load(&beats.seq);
+    unsigned long gap = (seq - last - 1) & BEAT_MASK;
+    unsigned long max = atomic_load(&beats.max_latency_us);
+    unsigned long missed = latency / (watch_dog.interval * 1000000UL);
+
+    (void)sig;
+    (void)context;
+
+    /* a beat still queued from a replaced peer says nothing about this one */
+    if(info->si_pid != other_pid)
+    {
+        return;
+    }
+
+    if(last && gap < BEAT_MASK / 2)
+    {
+        atomic_fetch_add(&beats.lost, gap);
+        missed = gap >= watch_dog.threshold && gap > missed ? gap : missed;
+    }
+
+    atomic_store(&beats.seq, seq);
+    atomic_fetch_add(&beats.received, 1);
+    atomic_store(&beats.last_latency_us, latency);
+    atomic_fetch_add(&beats.total_latency_us, latency);
+
+    while(latency > max &&
+            !atomic_compare_exchange_weak(&beats.max_latency_us, &max, latency))
+    {
+    }
+
+    atomic_store(&watch_dog.counter, missed);
+    WD_TRACE4(heartbeat_receive, watch_dog.location, info->si_pid, seq,
+                                                                    latency);
+
+#ifndef NDEBUG
+    UploadVerbose(LOGGER_NAME, "Received Signal 1", watch_dog.location);
+#endif
+}
+
+/*
+*   Only flags the stop, the scheduler wakes up from its wait and RunWD
+*   cleans up. The scheduler may not be running yet, or not exist between a
+*   revival and the new RunWD, destroying it from here would free it under
+*   RunWD's feet.
+*/
+static void SignalTwoHandler(int sig)
+{
+    (void)sig;
+
+#ifndef NDEBUG
+    UploadMessage(LOGGER_NAME, "Received Signal 2", watch_dog.location);
+#endif
+
+    stop_requested = 1;
+    WakeBackoff();
+
+    if(watch_dog.scheduler)
+    {
+        SchedulerStop(watch_dog.scheduler);
+    }
+}
+
+#ifndef NDEBUG
+static void ReportOverrun(ilrd_uid_t uid, size_t run_usec, void* param)
+{
+    char message[BUFSIZE];
+
+    (void)uid;
+    (void)param;
+
+    sprintf(message, "Task overran its budget, ran %lu usec",
+                                                    (unsigned long)run_usec);
+    UploadMessage(LOGGER_NAME, message, watch_dog.location);
+}
+#endif
+
+/*
+*   Ages every registered thread slot by one tick. A slot that wasn't kicked
+*   for @threshold ticks means its thread is hung, so the heartbeat is held
+*   back and the server revives the whole client. A slot still being claimed
+*   is skipped.
+*/
+static int ThreadsAreAlive(void)
+{
+    int i = 0;
+    int alive = 1;
+    int high_mark = atomic_load_explicit(&slots_high_mark,
+                                                        memory_order_relaxed);
+
+    for(; i < high_mark; ++i)
+    {
+        if(SLOT_ACTIVE == atomic_load_explicit(&thread_slots[i].in_use,
+                                                    memory_order_acquire)
+            && atomic_fetch_add_explicit(&thread_slots[i].missed, 1,
+                            memory_order_relaxed) >= watch_dog.threshold)
+        {
+            alive = 0;
+        }
+    }
+
+    return alive;
+}
+
+static void ResetThreads(void)
+{
+    int i = 0;
+    int high_mark = atomic_load(&slots_high_mark);
+
+    for(; i < high_mark; ++i)
+    {
+        atomic_store(&thread_slots[i].missed, 0);
+    }
+}
+
+/* in process mode the registered threads are the only heartbeat */
+static int CheckThreads()
+{
+    if(!ThreadsAreAlive())
+    {
+#ifndef NDEBUG
+        UploadMessage(LOGGER_NAME, "Thread hang detected", watch_dog.location);
+#endif
+        SchedulerStop(watch_dog.scheduler);
+    }
+
+    return 0;
+}
+
+static void SendBeat(void)
+{
+    union sigval value;
+
+    WD_FAULT_DELAY_BEAT();
+
+    if(WD_TRANSPORT_RTSIG != watch_dog.transport)
+    {
+        WD_TRACE3(heartbeat_send, watch_dog.location, other_pid, 0);
+        if(!WD_FAULT_DROP_BEAT())
+        {
+            kill(other_pid, SIGUSR1);
+        }
+        return;
+    }
+
+    ++watch_dog.send_seq;
+    WD_TRACE3(heartbeat_send, watch_dog.location, other_pid,
+                                                        watch_dog.send_seq);
+
+    if(WD_FAULT_DROP_BEAT())
+    {
+        return;
+    }
+    value.sival_ptr = (void*)(((watch_dog.send_seq & BEAT_MASK) << BEAT_BITS) |
+                                                    (NowUsec() & BEAT_MASK));
+
+    /* a full signal queue or a gone peer, the peer sees it as a gap */
+    if(-1 == sigqueue(other_pid, HEARTBEAT_RT_SIGNAL, value))
+    {
+        atomic_fetch_add(&beats.unsent, 1);
+    }
+}
+
+static int SendSignal()
+{
+    atomic_fetch_add(&watch_dog.counter, 1);
+
+    if(CLIENT == watch_dog.location && !ThreadsAreAlive())
+    {
+#ifndef NDEBUG
+        UploadMessage(LOGGER_NAME, "Thread hang detected, signal withheld",
+                                                        watch_dog.location);
+#endif
+        return 0;
+    }
+
+#ifndef NDEBUG
+    UploadVerbose(LOGGER_NAME, "Signal 1 sent", watch_dog.location);
+#endif
+
+    SendBeat();
+
+    return 0;
+}
+
+/*
+*   A silent peer isn't always a broken one. Stopped, D-state and starved
+*   peers get a few more windows, then a SIGABRT for a core dump, and only
+*   then are they revived. Dead, deadlocked and spinning peers are revived
+*   right away.
+*/
+static wd_verdict_t ClassifyPeer(void)
+{
+    wd_hang_t hang = ProcClassify(&watch_dog.peer);
+    wd_verdict_t verdict = VERDICT_REVIVE;
+
+    switch(hang)
+    {
+        case HANG_STOPPED:
+        case HANG_IO_WAIT:
+        case HANG_STARVED:
+            if(watch_dog.grace_rounds < watch_dog.max_grace)
+            {
+                ++watch_dog.grace_rounds;
+                verdict = VERDICT_WAIT;
+            }
+            else if(!watch_dog.escalated)
+            {
+                watch_dog.escalated = 1;
+                verdict = VERDICT_ESCALATE;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+#ifndef NDEBUG
+    {
+        static const char* verdicts[] = {"waiting", "escalating", "reviving"};
+        char message[BUFSIZE * 2];
+
+        sprintf(message, "Peer %d is %s, %s", other_pid, ProcHangName(hang),
+                                                            verdicts[verdict]);
+        UploadMessage(LOGGER_NAME, message, watch_dog.location);
+    }
+#endif
+
+    return verdict;
+}
+
+static int CheckTimer()
+{
+    wd_verdict_t verdict = VERDICT_REVIVE;
+
+    if(atomic_load(&watch_dog.counter) < watch_dog.threshold)
+    {
+        watch_dog.grace_rounds = 0;
+        watch_dog.escalated = 0;
+        ProcMark(&watch_dog.peer);
+
+        return 0;
+    }
+
+    verdict = ClassifyPeer();
+    WD_TRACE4(threshold_reached, watch_dog.location, other_pid,
+                                atomic_load(&watch_dog.counter), verdict);
+
+    switch(verdict)
+    {
+        case VERDICT_ESCALATE:
+            kill(other_pid, SIGABRT);
+            kill(other_pid, SIGCONT);
+            atomic_store(&watch_dog.counter, 0);
+            break;
+
+        case VERDICT_WAIT:
+            atomic_store(&watch_dog.counter, 0);
+            break;
+
+        default:
+#ifndef NDEBUG
+            UploadMessage(LOGGER_NAME, "Threshold reached", watch_dog.location);
+#endif
+            SchedulerStop(watch_dog.scheduler);
+            break;
+    }
+
+    return 0;
+}
+
+static int IsOverBudget(const proc_resources_t* sample)
+{
+    const wd_budget_t* budget = &watch_dog.budget;
+    unsigned long elapsed = sample->now_ticks - watch_dog.last_sample.now_ticks;
+    unsigned long used = sample->cpu_ticks - watch_dog.last_sample.cpu_ticks;
+
+    return (budget->max_rss_kb && sample->rss_kb > budget->max_rss_kb) ||
+           (budget->max_fds && sample->fds > budget->max_fds) ||
+           (budget->max_cpu_percent && elapsed &&
+                            used * 100 > budget->max_cpu_percent * elapsed);
+}
+
+static int SampleBudget()
+{
+    proc_resources_t sample;
+
+    if(!watch_dog.sampling || -1 == ProcResources(&watch_dog.peer, &sample))
+    {
+        return 0;
+    }
+
+    watch_dog.breaches = IsOverBudget(&sample) ? watch_dog.breaches + 1 : 0;
+    watch_dog.last_sample = sample;
+
+    if(watch_dog.breaches >= watch_dog.budget.breach_samples)
+    {
+#ifndef NDEBUG
+        char message[BUFSIZE * 2];
+
+        sprintf(message, "Budget breached: rss %lukB, %lu fds", sample.rss_kb,
+                                                                sample.fds);
+        UploadMessage(LOGGER_NAME, message, watch_dog.location);
+#endif
+        SchedulerStop(watch_dog.scheduler);
+    }
+
+    return 0;
+}
+
+static int SaveSnapshot()
+{
+    SnapshotSave(watch_dog.snapshot, watch_dog.scheduler);
+
+    return 0;
+}
+
+/*
+*   The timers of the process this one replaces, saved up to the moment it
+*   died. Its peer may take a few grace windows and a full backoff to revive
+*   it, an older snapshot belongs to an earlier run
+*/
+static void ResumeSnapshot(void)
+{
+    static const task_action_t bound[] = {SendSignal, CheckTimer,
+                                                CheckThreads, SampleBudget};
+    size_t max_age = watch_dog.interval * watch_dog.threshold *
+                    (watch_dog.max_grace + 2) + BACKOFF_MAX_MS / 1000;
+
+    watch_dog.snapshot = SnapshotOpen(snapshot_paths[watch_dog.location],
+                                    bound, sizeof(bound) / sizeof(*bound));
+    if(!watch_dog.snapshot)
+    {
+        return;
+    }
+
+    SnapshotRestore(watch_dog.snapshot, watch_dog.scheduler, max_age);
+    SchedulerAdd(watch_dog.scheduler, SaveSnapshot, NULL, watch_dog.interval);
+}
+
+/*
+*   Everything the run loop needs is allocated by now, so only the pages of
+*   a revival are left to fault in. The app keeps its own paging policy
+*/
+static void EnterRealtime(void)
+{
+    if(!RtLoad(&watch_dog.rt))
+    {
+        return;
+    }
+
+    SchedulerReserve(watch_dog.scheduler, RT_RESERVE_TASKS);
+    watch_dog.rt_failed = RtEnter(&watch_dog.rt, SERVER == watch_dog.location);
+
+#ifndef NDEBUG
+    if(watch_dog.rt_failed)
+    {
+        char message[BUFSIZE];
+
+        sprintf(message, "Real-time mode incomplete, failed steps %d",
+                                                        watch_dog.rt_failed);
+        UploadMessage(LOGGER_NAME, message, watch_dog.location);
+    }
+#endif
+}
+
+static int ReceiveFds()
+{
+    FdsReceive();
+
+    return 0;
+}
+
+/* budgets come from @WDSetBudget through the environment, all zero if unset */
+static int LoadBudget(void)
+{
+    char* budget = getenv(BUDGET_ENV_NAME);
+    wd_budget_t* output = &watch_dog.budget;
+
+    output->max_rss_kb = 0;
+    output->max_fds = 0;
+    output->max_cpu_percent = 0;
+    output->breach_samples = 0;
+
+    if(budget)
+    {
+        sscanf(budget, "%lu:%lu:%lu:%lu", &output->max_rss_kb,
+            &output->max_fds, &output->max_cpu_percent, &output->breach_samples);
+    }
+
+    if(0 == output->breach_samples)
+    {
+        output->breach_samples = 1;
+    }
+
+    return output->max_rss_kb || output->max_fds || output->max_cpu_percent;
+}
+
+/* runtime changes must reach the revived client through the environment */
+static void SaveBudget(void)
+{
+    const wd_budget_t* budget = &watch_dog.budget;
+    char buffer[BUFSIZE * 2];
+
+    sprintf(buffer, "%lu:%lu:%lu:%lu", budget->max_rss_kb, budget->max_fds,
+                            budget->max_cpu_percent, budget->breach_samples);
+    setenv(BUDGET_ENV_NAME, buffer, 1);
+}
+
+/*
+*   Added up front and idle until there's a budget, a budget set through
+*   wdctl mustn't allocate a task in the armed run loop
+*/
+static void AddSampler(void)
+{
+    watch_dog.has_sampler = !UIDIsSame(bad_uid, SchedulerAddEx(
+                            watch_dog.scheduler, SampleBudget, NULL,
+                            watch_dog.interval, SCHED_NORMAL, NULL,
+                            &watch_dog.sampler));
+}
+
+static void StartSampling(void)
+{
+    watch_dog.breaches = 0;
+    ProcResources(&watch_dog.peer, &watch_dog.last_sample);
+    watch_dog.sampling = 1;
+}
+
+static void CurrentConfig(wd_config_t* config)
+{
+    config->threshold = watch_dog.threshold;
+    config->interval = watch_dog.interval;
+    config->grace_rounds = watch_dog.max_grace;
+    config->log_level = watch_dog.log_level;
+}
+
+static void SetConfig(const wd_config_t* config)
+{
+    watch_dog.threshold = config->threshold;
+    watch_dog.interval = config->interval;
+    watch_dog.max_grace = config->grace_rounds;
+    watch_dog.log_level = config->log_level;
+
+#ifndef NDEBUG
+    LoggerSetLevel((log_level_t)config->log_level);
+#endif
+}
+
+/*
+*   wdctl changes reach the processes this one starts next. setenv allocates,
+*   so they're exported on the way to a revival, out of the armed run loop
+*/
+static void ExportSettings(void)
+{
+    wd_config_t config;
+
+    CurrentConfig(&config);
+    CtlExportConfig(&config);
+
+    /* the client never loads one, it would clear the app's */
+    if(CLIENT != watch_dog.location)
+    {
+        SaveBudget();
+    }
+}
+
+/* the tasks are moved in place, they keep their uids and stats */
+static void Retime(void)
+{
+    SchedulerReschedule(watch_dog.scheduler, watch_dog.heartbeat,
+                                                        watch_dog.interval);
+
+    if(INPROC != watch_dog.location)
+    {
+        SchedulerReschedule(watch_dog.scheduler, watch_dog.timer,
+                                    watch_dog.interval * watch_dog.threshold);
+    }
+
+    if(watch_dog.has_sampler)
+    {
+        SchedulerReschedule(watch_dog.scheduler, watch_dog.sampler,
+                                                        watch_dog.interval);
+    }
+}
+
+/* client side, the server pushes every change made through wdctl */
+static int ReceiveConfig()
+{
+    wd_config_t config;
+
+    CurrentConfig(&config);
+
+    if(0 == CtlReceiveConfig(FdsSocket(), &config))
+    {
+        SetConfig(&config);
+        Retime();
+    }
+
+    return 0;
+}
+
+static size_t* BudgetField(const char* key)
+{
+    wd_budget_t* budget = &watch_dog.budget;
+
+    if(0 == strcmp(key, "rss"))
+    {
+        return &budget->max_rss_kb;
+    }
+
+    if(0 == strcmp(key, "fds"))
+    {
+        return &budget->max_fds;
+    }
+
+    if(0 == strcmp(key, "cpu"))
+    {
+        return &budget->max_cpu_percent;
+    }
+
+    return 0 == strcmp(key, "samples") ? &budget->breach_samples : NULL;
+}
+
+static const char* SetBudgetValue(size_t* field, size_t value)
+{
+    const wd_budget_t* budget = &watch_dog.budget;
+
+    if(field == &watch_dog.budget.breach_samples && !value)
+    {
+        return "error: samples must be positive\n";
+    }
+
+    *field = value;
+
+    if(!watch_dog.sampling &&
+        (budget->max_rss_kb || budget->max_fds || budget->max_cpu_percent))
+    {
+        StartSampling();
+    }
+
+    return "ok\n";
+}
+
+/*
+*   The client is told first. It picks the change up within CTL_POLL_SEC, so
+*   a longer interval never makes it think the server hung
+*/
+static const char* SetValue(const char* key, size_t value)
+{
+    wd_config_t config;
+    size_t* field = BudgetField(key);
+
+    if(field)
+    {
+        return SetBudgetValue(field, value);
+    }
+
+    CurrentConfig(&config);
+
+    if(0 == strcmp(key, "threshold"))
+    {
+        config.threshold = value;
+    }
+    else if(0 == strcmp(key, "interval"))
+    {
+        config.interval = value;
+    }
+    else if(0 == strcmp(key, "grace"))
+    {
+        config.grace_rounds = value;
+    }
+    else if(0 == strcmp(key, "log") && value <= LOG_VERBOSE)
+    {
+        config.log_level = (int)value;
+    }
+    else
+    {
+        return "error: unknown key or bad value\n";
+    }
 
-#ifndef NDEBUG
+    if(-1 == CtlCheckConfig(&config))
+    {
+        return "error: value out of bounds\n";
+    }
 
-#include "logger.h"
-#define LOGGER_NAME ("WatchDogLogger.txt")
+    if(-1 != FdsSocket() && -1 == CtlSendConfig(FdsSocket(), &config))
+    {
+        return "error: can't reach the client\n";
+    }
 
-#endif
+    SetConfig(&config);
+    Retime();
 
-typedef struct watch_dog
+    return "ok\n";
+}
+
+static void ReportStatus(char* reply)
 {
-    size_t threshold;
-    size_t interval;
-    int argc;
-    wd_type_t location;
-    scheduler_t* scheduler;
-    atomic_uint counter;
-} watch_dog_t;
+    static const char* roles[] = {"client", "server", "inproc"};
+    static const char* lanes[] = {"critical", "normal"};
+    sched_task_info_t tasks[STATUS_MAX_TASKS];
+    const wd_budget_t* budget = &watch_dog.budget;
+    wd_metrics_t metrics;
+    time_t now = time(NULL);
+    size_t count = SchedulerSnapshot(watch_dog.scheduler, tasks,
+                                                            STATUS_MAX_TASKS);
+    size_t i = 0;
 
-watch_dog_t watch_dog;
-sem_t* inner_sem;
-pid_t other_pid;
+    WDGetMetrics(&metrics);
 
-/**********************Static Functions Implementation*************************/
+    reply += sprintf(reply, "role %s pid %d peer %d\n",
+                    roles[watch_dog.location], (int)getpid(), (int)other_pid);
+    reply += sprintf(reply, "threshold %lu interval %lu grace %lu log %d\n",
+                    watch_dog.threshold, watch_dog.interval,
+                    watch_dog.max_grace, watch_dog.log_level);
+    reply += sprintf(reply, "unanswered %u grace_used %lu\n",
+                    atomic_load(&watch_dog.counter), watch_dog.grace_rounds);
+    reply += sprintf(reply, "budget rss %lu fds %lu cpu %lu samples %lu "
+                    "breaches %lu\n", budget->max_rss_kb, budget->max_fds,
+                    budget->max_cpu_percent, budget->breach_samples,
+                    watch_dog.breaches);
+    reply += sprintf(reply, "restarts client %lu server %lu degraded %d\n",
+                    metrics.client_restarts, metrics.server_restarts,
+                    metrics.degraded);
+    reply += sprintf(reply, "beats %s received %lu lost %lu unsent %lu "
+                    "latency_us %lu max %lu mean %lu\n",
+                    WD_TRANSPORT_RTSIG == watch_dog.transport ? "rtsig" : "sigusr",
+                    metrics.beats_received, metrics.beats_lost,
+                    metrics.beats_unsent, metrics.last_latency_us,
+                    metrics.max_latency_us, metrics.mean_latency_us);
+    reply += sprintf(reply, "overruns %lu\n",
+                    SchedulerOverruns(watch_dog.scheduler));
 
-static void SignalOneHandler(int sig)
+    if(-1 != watch_dog.rt_failed)
+    {
+        reply += sprintf(reply, "realtime cpu %d priority %d locked %d "
+                    "fifo %d pinned %d\n", watch_dog.rt.cpu,
+                    watch_dog.rt.priority,
+                    !(watch_dog.rt_failed & RT_FAILED_LOCK),
+                    !(watch_dog.rt_failed & RT_FAILED_PRIORITY),
+                    !(watch_dog.rt_failed & RT_FAILED_AFFINITY));
+    }
+
+    for(; i < count; ++i)
+    {
+        reply += sprintf(reply, "task %lu lane %s interval %lu next %ld "
+                    "runs %lu max_run_usec %lu max_late_usec %lu\n", i,
+                    lanes[tasks[i].priority], tasks[i].interval_in_sec,
+                    (long)(tasks[i].time_to_run - now),
+                    tasks[i].stats.run_count, tasks[i].stats.max_run_usec,
+                    tasks[i].stats.max_late_usec);
+    }
+}
+
+static void HandleRequest(const char* request, char* reply)
 {
-    (void)sig;
-    atomic_store(&watch_dog.counter, 0);
+    char key[BUFSIZE];
+    char number[BUFSIZE];
+    size_t value = 0;
+    char extra = 0;
 
-#ifndef NDEBUG
-    UploadMessage(LOGGER_NAME, "Received Signal 1", watch_dog.location);
-#endif
+    if(0 == strcmp(request, "status"))
+    {
+        ReportStatus(reply);
+    }
+    else if(2 == sscanf(request, "set %63s %63s %c", key, number, &extra))
+    {
+        strcpy(reply, -1 == CtlParseValue(number, &value) ?
+                            "error: not a count\n" : SetValue(key, value));
+    }
+    else
+    {
+        sprintf(reply, "error: unknown request \"%.64s\"\n", request);
+    }
 }
 
-static void SignalTwoHandler(int sig)
+/* server side, polled every CTL_POLL_SEC whatever the interval is */
+static int ServeControl()
 {
-    (void)sig;
+    char request[CTL_MAX_REQUEST];
+    char reply[CTL_MAX_REPLY];
+    int conn = -1;
 
-#ifndef NDEBUG
-    UploadMessage(LOGGER_NAME, "Received Signal 2", watch_dog.location);
-#endif
+    while(-1 != (conn = CtlAccept(watch_dog.control, request,
+                                                            sizeof(request))))
+    {
+        HandleRequest(request, reply);
+        CtlReply(conn, reply);
+    }
 
-    SchedulerDestroy(watch_dog.scheduler);   
-    sem_close(inner_sem);
-    sem_unlink(SEM_NAME);
+    return 0;
 }
 
-static int SendSignal()
+/* the client history survives the exec through the environment */
+static void LoadHistory(restart_history_t* history)
 {
-    atomic_fetch_add(&watch_dog.counter, 1);
+    char* buffer = getenv(RESTARTS_ENV_NAME);
 
-#ifndef NDEBUG
-    UploadMessage(LOGGER_NAME, "Signal 1 sent", watch_dog.location);
-#endif
+    memset(history, 0, sizeof(restart_history_t));
+
+    if(buffer)
+    {
+        sscanf(buffer, "%lu:%lu:%ld:%ld:%lu:%d", &history->restarts,
+                &history->window_restarts, &history->window_start,
+                &history->last_restart, &history->backoff_ms, &history->degraded);
+    }
+}
 
-    kill(other_pid, SIGUSR1);
+/* degraded clears once a side stays up for a whole window */
+static int IsDegraded(const restart_history_t* history, long now)
+{
+    return history->degraded && now - history->last_restart <
+                                                        RESTART_WINDOW_SEC;
+}
+
+static void SaveHistory(const restart_history_t* history)
+{
+    char buffer[BUFSIZE * 2];
+
+    sprintf(buffer, "%lu:%lu:%ld:%ld:%lu:%d", history->restarts,
+                history->window_restarts, history->window_start,
+                history->last_restart, history->backoff_ms, history->degraded);
+    setenv(RESTARTS_ENV_NAME, buffer, 1);
+}
+
+/*
+*   The pipe Backoff waits on, left open for the life of the process since a
+*   late SIGUSR2 may still write to it. Drained for every run
+*/
+static int OpenStopPipe(void)
+{
+    char drain[16];
+    int i = 0;
+
+    if(-1 == stop_pipe[0])
+    {
+        if(-1 == pipe(stop_pipe))
+        {
+            return -1;
+        }
+
+        for(; i < 2; ++i)
+        {
+            fcntl(stop_pipe[i], F_SETFL, fcntl(stop_pipe[i], F_GETFL) |
+                                                                O_NONBLOCK);
+            fcntl(stop_pipe[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+
+    while(read(stop_pipe[0], drain, sizeof(drain)) > 0)
+    {
+    }
 
     return 0;
 }
 
-static int CheckTimer()
+/*
+*   Waits before a revival. The delay doubles on every restart up to
+*   BACKOFF_MAX_MS and is jittered by half. More than RESTART_BUDGET restarts
+*   in one window jump straight to the maximum and mark the side degraded,
+*   which clears once it stays up for a whole window. A stop request ends
+*   the wait early, the caller checks stop_requested before reviving.
+*/
+static void Backoff(restart_history_t* history)
 {
-    if(atomic_load(&watch_dog.counter) >= watch_dog.threshold)
+    static unsigned int seed = 0;
+    struct pollfd wake;
+    unsigned long deadline = 0;
+    unsigned long now_us = 0;
+    size_t delay_ms = 0;
+    long now = time(NULL);
+
+    if(now - history->last_restart >= RESTART_WINDOW_SEC)
+    {
+        history->backoff_ms = 0;
+        history->degraded = 0;
+    }
+
+    if(now - history->window_start >= RESTART_WINDOW_SEC)
+    {
+        history->window_start = now;
+        history->window_restarts = 0;
+    }
+
+    ++history->restarts;
+    ++history->window_restarts;
+
+    if(history->window_restarts > RESTART_BUDGET)
     {
 #ifndef NDEBUG
-        UploadMessage(LOGGER_NAME, "Threshold reached", watch_dog.location);
+        if(!history->degraded)
+        {
+            UploadMessage(LOGGER_NAME, "Crash loop, degraded",
+                                                        watch_dog.location);
+        }
 #endif
-        
-        SchedulerStop(watch_dog.scheduler);
+        history->degraded = 1;
     }
 
-    return 0;
+    if(history->degraded || history->backoff_ms * 2 > BACKOFF_MAX_MS)
+    {
+        history->backoff_ms = BACKOFF_MAX_MS;
+    }
+    else
+    {
+        history->backoff_ms = history->backoff_ms ? history->backoff_ms * 2 :
+                                                            BACKOFF_BASE_MS;
+    }
+
+    seed = seed ? seed : (unsigned int)(getpid() ^ now);
+    delay_ms = history->backoff_ms / 2 + rand_r(&seed) %
+                                                (history->backoff_ms / 2 + 1);
+    deadline = NowUsec() + delay_ms * 1000;
+    wake.fd = stop_pipe[0];
+    wake.events = POLLIN;
+
+    while(!stop_requested && (now_us = NowUsec()) < deadline)
+    {
+        poll(&wake, 1, (int)((deadline - now_us + 999) / 1000));
+    }
+
+    history->last_restart = time(NULL);
 }
 
+/*
+*   Returns only if a stop called the revival off, this thread is then still
+*   the one StopWD joins. Otherwise StartWD hands over to a new thread under
+*   revive_lock, so StopWD sees either this thread or the new one
+*/
 static void ReviveServer(char** argv)
 {
+    scheduler_t* stopped = NULL;
+
+    WD_TRACE2(revive_start, watch_dog.location, other_pid);
+
+    /* a hung server is still alive, waiting for it would block forever */
+    kill(other_pid, SIGKILL);
     waitpid(other_pid, NULL, 0);
+    Backoff(&server_history);
+
+    pthread_mutex_lock(&revive_lock);
+
+    if(stop_requested)
+    {
+        pthread_mutex_unlock(&revive_lock);
+        return;
+    }
+
+    /* the new thread creates its own, the old one is out of its run loop */
+    stopped = watch_dog.scheduler;
+    watch_dog.scheduler = NULL;
+    SchedulerDestroy(stopped);
+
+    ExportSettings();
     StartWD(watch_dog.threshold, watch_dog.interval, watch_dog.argc, argv);
+
+    /* the new watchdog process left its pid in the environment */
+    WD_TRACE3(revive_end, watch_dog.location, getenv(ENV_VAR_NAME) ?
+                atoi(getenv(ENV_VAR_NAME)) : -1, server_history.backoff_ms);
     pthread_detach(pthread_self());
+    pthread_mutex_unlock(&revive_lock);
     pthread_exit(NULL);
 }
 
 static void ReviveClient(char** argv)
 {
-    execvp(argv[0], argv);
+    restart_history_t history;
+
+    WD_TRACE2(revive_start, watch_dog.location, other_pid);
+
+    /* a hung client is still alive and still our parent */
+    if(getppid() == other_pid)
+    {
+        kill(other_pid, SIGKILL);
+    }
+
+    LoadHistory(&history);
+    Backoff(&history);
+    SaveHistory(&history);
+    ExportSettings();
+    FdsReceive();
+    FdsExport();
+    WD_TRACE3(revive_end, watch_dog.location, getpid(), history.backoff_ms);
+
+    if(!stop_requested)
+    {
+        execvp(argv[0], argv);
+    }
 }
 
-/*****************************API Function*************************************/
+static void ReexecSelf(char** argv)
+{
+    restart_history_t history;
 
-int RunWD(size_t threshold, size_t interval, int argc, char** argv,
-                                                            wd_type_t location)
+    WD_TRACE2(revive_start, watch_dog.location, getpid());
+
+    LoadHistory(&history);
+    Backoff(&history);
+    SaveHistory(&history);
+    ExportSettings();
+    FdsKeepOnExec();
+    FdsExport();
+    WD_TRACE3(revive_end, watch_dog.location, getpid(), history.backoff_ms);
+
+    if(!stop_requested)
+    {
+        execvp(argv[0], argv);
+    }
+}
+
+/* returns 0 if the watchdog should keep watching */
+static int TakeAction(char** argv)
 {
-    struct sigaction action = {0};
+    switch(in_process.action)
+    {
+        case WD_ACTION_HOOK:
+            in_process.hook(in_process.param);
+            ResetThreads();
+            watch_dog.breaches = 0;
+            return 0;
+
+        case WD_ACTION_REEXEC:
+            ReexecSelf(argv);
+            break;
+
+        default:
+            break;
+    }
 
-    action.sa_handler = SignalOneHandler;
-    
-    if(-1 == sigaction(SIGUSR1, &action, NULL))
+    /* a failed re-exec still leaves a core dump behind */
+    if(!stop_requested)
     {
-        return -1;
+        abort();
     }
 
-    action.sa_handler = SignalTwoHandler;
+    return 1;
+}
+
+/*****************************API Functions************************************/
+
+int WDRegisterThread(void)
+{
+    int i = 0;
+    int expected = SLOT_FREE;
+    int high_mark = 0;
 
-    if(-1 == sigaction(SIGUSR2, &action, NULL))
+    for(; i < WD_MAX_THREADS; ++i, expected = SLOT_FREE)
     {
-        return -1;
+        if(atomic_compare_exchange_strong(&thread_slots[i].in_use,
+                                                    &expected, SLOT_CLAIMING))
+        {
+            atomic_store(&thread_slots[i].missed, 0);
+            atomic_store(&thread_slots[i].in_use, SLOT_ACTIVE);
+            high_mark = atomic_load(&slots_high_mark);
+
+            while(high_mark <= i && !atomic_compare_exchange_weak(
+                                        &slots_high_mark, &high_mark, i + 1))
+            {
+            }
+
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void WDUnregisterThread(int slot)
+{
+    assert(0 <= slot && slot < WD_MAX_THREADS);
+
+    atomic_store(&thread_slots[slot].in_use, SLOT_FREE);
+}
+
+void WDKick(int slot)
+{
+    assert(0 <= slot && slot < WD_MAX_THREADS);
+
+    atomic_store_explicit(&thread_slots[slot].missed, 0, memory_order_relaxed);
+}
+
+void WDGetMetrics(wd_metrics_t* metrics)
+{
+    restart_history_t history;
+    long now = time(NULL);
+
+    assert(metrics);
+
+    LoadHistory(&history);
+
+    metrics->client_restarts = history.restarts;
+    metrics->server_restarts = server_history.restarts;
+    metrics->backoff_ms = history.last_restart > server_history.last_restart ?
+                                history.backoff_ms : server_history.backoff_ms;
+    metrics->degraded = IsDegraded(&history, now) ||
+                                        IsDegraded(&server_history, now);
+    metrics->beats_received = atomic_load(&beats.received);
+    metrics->beats_lost = atomic_load(&beats.lost);
+    metrics->beats_unsent = atomic_load(&beats.unsent);
+    metrics->last_latency_us = atomic_load(&beats.last_latency_us);
+    metrics->max_latency_us = atomic_load(&beats.max_latency_us);
+    metrics->mean_latency_us = metrics->beats_received ?
+            atomic_load(&beats.total_latency_us) / metrics->beats_received : 0;
+}
+
+void InProcessInit(wd_action_t action, wd_hook_t hook, void* param)
+{
+    assert(WD_ACTION_HOOK != action || hook);
+
+    in_process.action = action;
+    in_process.hook = hook;
+    in_process.param = param;
+    sem_init(&in_process.ready, 0, 0);
+}
+
+int InProcessWait(void)
+{
+    sem_wait(&in_process.ready);
+    sem_destroy(&in_process.ready);
+
+    return watch_dog.scheduler ? 0 : -1;
+}
+
+void ReviveLock(void)
+{
+    pthread_mutex_lock(&revive_lock);
+}
+
+void ReviveUnlock(void)
+{
+    pthread_mutex_unlock(&revive_lock);
+}
+
+void InProcessStop(void)
+{
+    stop_requested = 1;
+    WakeBackoff();
+
+    if(watch_dog.scheduler)
+    {
+        SchedulerStop(watch_dog.scheduler);
     }
+}
 
-    inner_sem = sem_open(SEM_NAME, O_RDWR);
+int RunWD(size_t threshold, size_t interval, int argc, char** argv,
+                                                            wd_type_t location)
+{
+    struct sigaction action = {0};
+    sched_status_t status = SCHED_SUCCESS;
+    wd_config_t config;
 
-    if(SEM_FAILED == inner_sem)
+    /* the app owns its signals, and the handshake is within the process */
+    if(INPROC == location)
     {
-        return -1;
+        inner_sem = &in_process.ready;
+    }
+    else
+    {
+        action.sa_handler = SignalOneHandler;
+
+        if(-1 == sigaction(SIGUSR1, &action, NULL))
+        {
+            return -1;
+        }
+
+        action.sa_handler = SignalTwoHandler;
+
+        if(-1 == sigaction(SIGUSR2, &action, NULL))
+        {
+            return -1;
+        }
+
+        action.sa_sigaction = RtSignalHandler;
+        action.sa_flags = SA_SIGINFO;
+
+        if(-1 == sigaction(HEARTBEAT_RT_SIGNAL, &action, NULL))
+        {
+            return -1;
+        }
+
+        inner_sem = sem_open(SEM_NAME, O_RDWR);
+
+        if(SEM_FAILED == inner_sem)
+        {
+            return -1;
+        }
     }
 
+    stop_requested = 0;
     watch_dog.threshold = threshold;
     watch_dog.interval = interval;
+    watch_dog.max_grace = MAX_GRACE_ROUNDS;
+    watch_dog.log_level = LOG_VERBOSE;
     watch_dog.argc = argc;
     watch_dog.location = location;
+    watch_dog.control = -1;
+    watch_dog.sampling = 0;
+    watch_dog.has_sampler = 0;
+    watch_dog.transport = getenv(TRANSPORT_ENV_NAME) ?
+                                atoi(getenv(TRANSPORT_ENV_NAME)) : 0;
+    watch_dog.send_seq = 0;
+    watch_dog.rt_failed = -1;
+    atomic_store(&beats.seq, 0);
+    WD_FAULT_LOAD(location);
+
+    /* settings changed through wdctl outlive revivals */
+    CurrentConfig(&config);
+
+    if(0 == CtlImportConfig(&config))
+    {
+        SetConfig(&config);
+    }
+
     atomic_init(&watch_dog.counter, 0);
-    watch_dog.scheduler = SchedulerCreate();
+    watch_dog.scheduler = 0 == OpenStopPipe() ? SchedulerCreate() : NULL;
 
     if(!watch_dog.scheduler)
     {
+        if(INPROC == location)
+        {
+            sem_post(inner_sem);
+            return -1;
+        }
+
         sem_close(inner_sem);
         sem_unlink(SEM_NAME);
         return -1;
     }
 
+#ifndef NDEBUG
+    SchedulerSetOverrunHandler(watch_dog.scheduler, ReportOverrun, NULL);
+#endif
+
     switch(location)
     {
         case CLIENT:
             other_pid = atoi(getenv(ENV_VAR_NAME));
             break;
 
+        case INPROC:
+            other_pid = getpid();
+            break;
+
         default:
             other_pid = getppid();
             break;
     }
 
-    SchedulerAdd(watch_dog.scheduler, SendSignal, NULL, watch_dog.interval);
-    SchedulerAdd(watch_dog.scheduler, CheckTimer, NULL, watch_dog.interval *
-                                                        watch_dog.threshold);
+    ProcOpen(&watch_dog.peer, other_pid);
+    watch_dog.grace_rounds = 0;
+    watch_dog.escalated = 0;
+
+    if(INPROC == location)
+    {
+        SchedulerAddEx(watch_dog.scheduler, CheckThreads, NULL,
+                    watch_dog.interval, SCHED_CRITICAL, NULL,
+                    &watch_dog.heartbeat);
+    }
+    else
+    {
+        SchedulerAddEx(watch_dog.scheduler, SendSignal, NULL,
+                    watch_dog.interval, SCHED_CRITICAL, NULL,
+                    &watch_dog.heartbeat);
+        SchedulerAddEx(watch_dog.scheduler, CheckTimer, NULL,
+                    watch_dog.interval * watch_dog.threshold, SCHED_CRITICAL,
+                    NULL, &watch_dog.timer);
+    }
+
+    if(SERVER == location && getenv(SOCKET_ENV_NAME))
+    {
+        FdsServe(atoi(getenv(SOCKET_ENV_NAME)));
+        SchedulerAdd(watch_dog.scheduler, ReceiveFds, NULL, watch_dog.interval);
+    }
+
+    if(CLIENT == location)
+    {
+        SchedulerAdd(watch_dog.scheduler, ReceiveConfig, NULL, CTL_POLL_SEC);
+    }
+    else if(-1 != (watch_dog.control = CtlListen(CTL_PATH)))
+    {
+        SchedulerAdd(watch_dog.scheduler, ServeControl, NULL, CTL_POLL_SEC);
+    }
+
+    if(CLIENT != location)
+    {
+        AddSampler();
+
+        if(LoadBudget())
+        {
+            StartSampling();
+        }
+    }
+
+    ResumeSnapshot();
+    EnterRealtime();
     sem_post(inner_sem);
 
-    if(SCHED_STOPPED == SchedulerRun(watch_dog.scheduler))
+    /* the in process hook is app code, it may allocate */
+    do
+    {
+        RtArm();
+        status = SchedulerRun(watch_dog.scheduler);
+        RtDisarm();
+    } while(INPROC == location && SCHED_STOPPED == status && !stop_requested
+                                                    && 0 == TakeAction(argv));
+
+    ProcClose(&watch_dog.peer);
+
+    /* a clean stop leaves nothing to resume */
+    if(watch_dog.snapshot && !stop_requested)
+    {
+        SnapshotSave(watch_dog.snapshot, watch_dog.scheduler);
+    }
+    SnapshotClose(watch_dog.snapshot, stop_requested);
+
+    if(!stop_requested && SCHED_STOPPED == status)
     {
 #ifndef NDEBUG
         UploadMessage(LOGGER_NAME, "Crashed, restart now", !watch_dog.location);
@@ -172,6 +1411,25 @@ int RunWD(size_t threshold, size_t interval, int argc, char** argv,
                 ReviveClient(argv);
                 break;
         }
+
+        /* called off during the backoff, after the snapshot was kept */
+        if(stop_requested)
+        {
+            unlink(snapshot_paths[location]);
+        }
+    }
+
+    if(stop_requested)
+    {
+        SchedulerDestroy(watch_dog.scheduler);
+        watch_dog.scheduler = NULL;
+        CtlClose(watch_dog.control, CTL_PATH);
+
+        if(INPROC != location)
+        {
+            sem_close(inner_sem);
+            sem_unlink(SEM_NAME);
+        }
     }
 
     return 0;
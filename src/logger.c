@@ -1,15 +1,67 @@
-#include <stdio.h>
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>      /* open, O_APPEND, O_CREAT */
+#include <unistd.h>     /* close */
+#include <string.h>     /* strlen */
+#include <sys/uio.h>    /* writev, struct iovec */
 
 #include "logger.h"
+#include "wd_fault.h"
 
-char* role[2] = {"Client", "Server"};
+#define LINE_PARTS (4)
 
-int UploadMessage(const char* filename, const char* message, int location)
+char* role[3] = {"Client", "Server", "InProc"};
+
+static log_level_t current_level = LOG_VERBOSE;
+
+static int Upload(const char* filename, const char* message, int location,
+                                                            log_level_t level)
 {
-    FILE* logger = fopen(filename, "a");
+    struct iovec line[LINE_PARTS];
+    int logger = -1;
+
+    if(level > current_level)
+    {
+        return 0;
+    }
+
+    WD_FAULT_SLOW_LOG();
+
+    /* no stdio, a real-time watchdog thread must not allocate */
+    logger = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
+
+    if(-1 == logger)
+    {
+        return -1;
+    }
 
-    fprintf(logger, "%s: %s\n" ,role[location], message);
-    fclose(logger);
+    line[0].iov_base = role[location];
+    line[0].iov_len = strlen(role[location]);
+    line[1].iov_base = ": ";
+    line[1].iov_len = 2;
+    line[2].iov_base = (char*)message;
+    line[2].iov_len = strlen(message);
+    line[3].iov_base = "\n";
+    line[3].iov_len = 1;
+
+    /* one append, so lines of both sides never interleave */
+    writev(logger, line, LINE_PARTS);
+    close(logger);
 
     return 0;
+}
+
+int UploadMessage(const char* filename, const char* message, int location)
+{
+    return Upload(filename, message, location, LOG_EVENTS);
+}
+
+int UploadVerbose(const char* filename, const char* message, int location)
+{
+    return Upload(filename, message, location, LOG_VERBOSE);
+}
+
+void LoggerSetLevel(log_level_t level)
+{
+    current_level = level;
 }
\ No newline at end of file
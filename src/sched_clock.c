@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>     /* assert */
+#include <stdlib.h>     /* malloc, free */
+
+#include "sched_clock.h"
+
+struct sched_clock
+{
+    struct timespec now;
+};
+
+/*****************************API Functions************************************/
+
+sched_clock_t* ClockCreateSimulated(time_t start)
+{
+    sched_clock_t* clock = (sched_clock_t*)malloc(sizeof(sched_clock_t));
+
+    if(!clock)
+    {
+        return NULL;
+    }
+
+    clock->now.tv_sec = start;
+    clock->now.tv_nsec = 0;
+
+    return clock;
+}
+
+void ClockDestroy(sched_clock_t* clock)
+{
+    free(clock);
+}
+
+time_t ClockTime(const sched_clock_t* clock)
+{
+    return clock ? clock->now.tv_sec : time(NULL);
+}
+
+void ClockRealtime(const sched_clock_t* clock, struct timespec* now)
+{
+    assert(now);
+
+    if(clock)
+    {
+        *now = clock->now;
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, now);
+}
+
+void ClockMonotonic(const sched_clock_t* clock, struct timespec* now)
+{
+    assert(now);
+
+    if(clock)
+    {
+        *now = clock->now;
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, now);
+}
+
+void ClockAdvance(sched_clock_t* clock, size_t usec)
+{
+    assert(clock);
+
+    clock->now.tv_sec += usec / 1000000;
+    clock->now.tv_nsec += (long)(usec % 1000000) * 1000;
+
+    if(clock->now.tv_nsec >= 1000000000L)
+    {
+        ++clock->now.tv_sec;
+        clock->now.tv_nsec -= 1000000000L;
+    }
+}
+
+void ClockJumpTo(sched_clock_t* clock, time_t when)
+{
+    assert(clock);
+
+    if(when > clock->now.tv_sec)
+    {
+        clock->now.tv_sec = when;
+        clock->now.tv_nsec = 0;
+    }
+}
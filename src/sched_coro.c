@@ -0,0 +1,218 @@
+#include <assert.h>     /* assert */
+#include <stdlib.h>     /* malloc, free */
+#include <string.h>     /* memset */
+
+#include "sched_coro.h"
+#include "typed_ds.h"
+
+#define POOL_CHUNK (256)
+#define FRAME_ALIGN (sizeof(void*) * 2)
+#define ALIGN_UP(x) (((x) + FRAME_ALIGN - 1) / FRAME_ALIGN * FRAME_ALIGN)
+
+struct co_frame
+{
+    int resume_point;
+    unsigned long wake_tick;
+    co_func_t func;
+    void* params;
+    co_frame_t* next_free;
+};
+
+typedef struct pool_chunk
+{
+    struct pool_chunk* next;
+} pool_chunk_t;
+
+#define FRAME_LESS(a, b) ((a)->wake_tick < (b)->wake_tick)
+
+DEFINE_PQ(FramePQ, co_frame_t*, FRAME_LESS)
+
+struct co_runtime
+{
+    scheduler_t* scheduler;
+    ilrd_uid_t pump;
+    FramePQ_t ready;
+    co_frame_t* free_frames;
+    pool_chunk_t* chunks;
+    size_t frame_size;
+    size_t locals_size;
+    unsigned long tick;
+};
+
+/**********************Static Functions Implementation*************************/
+
+/* frames are carved out of chunks, the pool only grows */
+static int GrowPool(co_runtime_t* runtime)
+{
+    size_t header = ALIGN_UP(sizeof(pool_chunk_t));
+    pool_chunk_t* chunk = (pool_chunk_t*)malloc(header +
+                                            POOL_CHUNK * runtime->frame_size);
+    co_frame_t* frame = NULL;
+    size_t i = 0;
+
+    if(!chunk)
+    {
+        return 1;
+    }
+
+    chunk->next = runtime->chunks;
+    runtime->chunks = chunk;
+
+    for(; i < POOL_CHUNK; ++i)
+    {
+        frame = (co_frame_t*)((char*)chunk + header + i * runtime->frame_size);
+        frame->next_free = runtime->free_frames;
+        runtime->free_frames = frame;
+    }
+
+    return 0;
+}
+
+static void ReleaseFrame(co_runtime_t* runtime, co_frame_t* frame)
+{
+    frame->next_free = runtime->free_frames;
+    runtime->free_frames = frame;
+}
+
+static int Pump(void* params)
+{
+    co_runtime_t* runtime = (co_runtime_t*)params;
+    co_frame_t* frame = NULL;
+
+    ++runtime->tick;
+
+    while(!FramePQIsEmpty(&runtime->ready) &&
+                    (*FramePQPeek(&runtime->ready))->wake_tick <= runtime->tick)
+    {
+        frame = FramePQDequeue(&runtime->ready);
+        frame->wake_tick = runtime->tick;
+
+        if(CO_DONE == frame->func(frame, frame->params) ||
+                                FramePQEnqueue(&runtime->ready, frame))
+        {
+            ReleaseFrame(runtime, frame);
+        }
+    }
+
+    return 0;
+}
+
+/*****************************API Functions************************************/
+
+co_runtime_t* CoRuntimeCreate(scheduler_t* scheduler, size_t tick_sec,
+                                                        size_t locals_size)
+{
+    co_runtime_t* runtime = NULL;
+
+    assert(scheduler);
+
+    runtime = (co_runtime_t*)malloc(sizeof(co_runtime_t));
+
+    if(!runtime)
+    {
+        return NULL;
+    }
+
+    if(FramePQCreate(&runtime->ready, POOL_CHUNK))
+    {
+        free(runtime);
+        return NULL;
+    }
+
+    runtime->scheduler = scheduler;
+    runtime->free_frames = NULL;
+    runtime->chunks = NULL;
+    runtime->locals_size = locals_size;
+    runtime->frame_size = ALIGN_UP(sizeof(co_frame_t)) + ALIGN_UP(locals_size);
+    runtime->tick = 0;
+    runtime->pump = SchedulerAdd(scheduler, Pump, runtime, tick_sec);
+
+    if(UIDIsSame(runtime->pump, bad_uid))
+    {
+        FramePQDestroy(&runtime->ready);
+        free(runtime);
+        return NULL;
+    }
+
+    return runtime;
+}
+
+void CoRuntimeDestroy(co_runtime_t* runtime)
+{
+    pool_chunk_t* chunk = NULL;
+
+    assert(runtime);
+
+    SchedulerRemove(runtime->scheduler, runtime->pump);
+    FramePQDestroy(&runtime->ready);
+
+    while(runtime->chunks)
+    {
+        chunk = runtime->chunks;
+        runtime->chunks = chunk->next;
+        free(chunk);
+    }
+
+    free(runtime);
+}
+
+int CoSpawn(co_runtime_t* runtime, co_func_t func, void* params)
+{
+    co_frame_t* frame = NULL;
+
+    assert(runtime);
+    assert(func);
+
+    if(!runtime->free_frames && GrowPool(runtime))
+    {
+        return 1;
+    }
+
+    frame = runtime->free_frames;
+    runtime->free_frames = frame->next_free;
+
+    frame->resume_point = 0;
+    frame->wake_tick = runtime->tick + 1;
+    frame->func = func;
+    frame->params = params;
+    memset(CoLocals(frame), 0, runtime->locals_size);
+
+    if(FramePQEnqueue(&runtime->ready, frame))
+    {
+        ReleaseFrame(runtime, frame);
+        return 1;
+    }
+
+    return 0;
+}
+
+size_t CoCount(const co_runtime_t* runtime)
+{
+    assert(runtime);
+
+    return FramePQSize(&runtime->ready);
+}
+
+void* CoLocals(co_frame_t* frame)
+{
+    assert(frame);
+
+    return (char*)frame + ALIGN_UP(sizeof(co_frame_t));
+}
+
+int CoResumePoint(const co_frame_t* frame)
+{
+    assert(frame);
+
+    return frame->resume_point;
+}
+
+co_status_t CoSuspend(co_frame_t* frame, size_t ticks, int resume_point)
+{
+    assert(frame);
+
+    frame->resume_point = resume_point;
+    frame->wake_tick += ticks ? ticks : 1;
+
+    return CO_SUSPENDED;
+}
@@ -0,0 +1,474 @@
+#define _GNU_SOURCE
+
+#include <assert.h>     /* assert */
+#include <stdlib.h>     /* malloc, free */
+#include <stdatomic.h>  /* atomic_int, atomic_size_t */
+#include <time.h>       /* time, clock_gettime */
+#include <unistd.h>     /* sysconf */
+#include <pthread.h>    /* pthread_create, pthread_mutex_t, pthread_cond_t */
+#include <sched.h>      /* cpu_set_t, CPU_SET */
+
+#include "sched_group.h"
+#include "task.h"
+#include "heap_pq.h"
+
+#define IDLE_SEC (1)
+#define FIB_HASH (2654435769UL)
+
+typedef struct shard
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    heap_pq_t* queue;
+    pthread_t thread;
+    size_t index;
+    atomic_int sleeping;
+    atomic_size_t runs;
+    atomic_size_t steals;
+    struct sched_group* group;
+} shard_t;
+
+/*
+*   Each shard is its own allocation, so the locks and counters of two
+*   shards don't share a cache line
+*/
+struct sched_group
+{
+    shard_t** shards;
+    size_t count;
+    size_t started;
+    atomic_int running;
+    atomic_size_t size;
+};
+
+/**********************Static Functions Implementation*************************/
+
+static unsigned long TaskKey(const void* task)
+{
+    assert(task);
+
+    return (unsigned long)TaskGetTimeToRun((const task_t*)task);
+}
+
+static size_t HomeOf(const sched_group_t* group, size_t key)
+{
+    return (((unsigned long)key * FIB_HASH) >> 16) % group->count;
+}
+
+static int IsDue(heap_pq_t* queue)
+{
+    return !PQIsEmpty(queue) &&
+                    TaskGetTimeToRun((task_t*)PQPeek(queue)) <= time(NULL);
+}
+
+static void DestroyShard(shard_t* shard)
+{
+    while(!PQIsEmpty(shard->queue))
+    {
+        TaskDestroy((task_t*)PQDequeue(shard->queue));
+    }
+
+    PQDestroy(shard->queue);
+    pthread_cond_destroy(&shard->wake);
+    pthread_mutex_destroy(&shard->lock);
+    free(shard);
+}
+
+static shard_t* CreateShard(sched_group_t* group, size_t index)
+{
+    shard_t* shard = (shard_t*)malloc(sizeof(shard_t));
+
+    if(!shard)
+    {
+        return NULL;
+    }
+
+    shard->queue = PQCreateRadix(TaskKey);
+    if(!shard->queue)
+    {
+        free(shard);
+        return NULL;
+    }
+
+    pthread_mutex_init(&shard->lock, NULL);
+    pthread_cond_init(&shard->wake, NULL);
+    shard->index = index;
+    shard->group = group;
+    atomic_init(&shard->sleeping, 0);
+    atomic_init(&shard->runs, 0);
+    atomic_init(&shard->steals, 0);
+
+    return shard;
+}
+
+static void Signal(shard_t* shard)
+{
+    pthread_mutex_lock(&shard->lock);
+    pthread_cond_signal(&shard->wake);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/* the caller holds no lock, a sleeping shard holds its own until it waits */
+static void WakeIdle(sched_group_t* group, const shard_t* self)
+{
+    size_t i = 1;
+
+    for(; i < group->count; ++i)
+    {
+        shard_t* shard = group->shards[(self->index + i) % group->count];
+
+        if(atomic_load_explicit(&shard->sleeping, memory_order_acquire))
+        {
+            Signal(shard);
+            return;
+        }
+    }
+}
+
+static task_t* TakeDue(shard_t* shard, int* backlog)
+{
+    task_t* task = NULL;
+
+    pthread_mutex_lock(&shard->lock);
+
+    if(IsDue(shard->queue))
+    {
+        task = (task_t*)PQDequeue(shard->queue);
+        *backlog = IsDue(shard->queue);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return task;
+}
+
+/* only trylock, a shard may steal while it holds its own lock */
+static task_t* Steal(sched_group_t* group, shard_t* self)
+{
+    task_t* task = NULL;
+    size_t i = 1;
+
+    for(; !task && i < group->count; ++i)
+    {
+        shard_t* victim = group->shards[(self->index + i) % group->count];
+
+        if(pthread_mutex_trylock(&victim->lock))
+        {
+            continue;
+        }
+
+        if(IsDue(victim->queue))
+        {
+            task = (task_t*)PQDequeue(victim->queue);
+        }
+
+        pthread_mutex_unlock(&victim->lock);
+    }
+
+    if(task)
+    {
+        atomic_fetch_add_explicit(&self->steals, 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/* stolen tasks go back to their home shard */
+static void RunTask(sched_group_t* group, shard_t* self, task_t* task)
+{
+    shard_t* home = group->shards[TaskGetSlot(task)];
+    int failed = 0;
+
+    atomic_fetch_add_explicit(&self->runs, 1, memory_order_relaxed);
+
+    if(TaskRun(task))
+    {
+        TaskDestroy(task);
+        atomic_fetch_sub(&group->size, 1);
+        return;
+    }
+
+    TaskSetTimeToRun(task);
+
+    pthread_mutex_lock(&home->lock);
+    failed = PQEnqueue(home->queue, task);
+    if(home != self)
+    {
+        pthread_cond_signal(&home->wake);
+    }
+    pthread_mutex_unlock(&home->lock);
+
+    if(failed)
+    {
+        TaskDestroy(task);
+        atomic_fetch_sub(&group->size, 1);
+    }
+}
+
+/*
+*   Waits for the next task of @shard, at most IDLE_SEC so due tasks of
+*   other shards get stolen even if nobody wakes it. @sleeping is set
+*   under the lock before the last steal, so a wake after it isn't lost
+*/
+static task_t* Sleep(sched_group_t* group, shard_t* shard)
+{
+    struct timespec until;
+    task_t* task = NULL;
+    time_t now = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    atomic_store_explicit(&shard->sleeping, 1, memory_order_release);
+
+    if(atomic_load(&group->running) && !IsDue(shard->queue) &&
+                                        !(task = Steal(group, shard)))
+    {
+        clock_gettime(CLOCK_REALTIME, &until);
+        now = until.tv_sec;
+        until.tv_sec += IDLE_SEC;
+        until.tv_nsec = 0;
+
+        if(!PQIsEmpty(shard->queue) &&
+                TaskGetTimeToRun((task_t*)PQPeek(shard->queue)) < until.tv_sec)
+        {
+            until.tv_sec = TaskGetTimeToRun((task_t*)PQPeek(shard->queue));
+            until.tv_sec = until.tv_sec > now ? until.tv_sec : now + 1;
+        }
+
+        pthread_cond_timedwait(&shard->wake, &shard->lock, &until);
+    }
+
+    atomic_store_explicit(&shard->sleeping, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&shard->lock);
+
+    return task;
+}
+
+static void* ShardMain(void* params)
+{
+    shard_t* shard = (shard_t*)params;
+    sched_group_t* group = shard->group;
+    task_t* task = NULL;
+    int backlog = 0;
+
+    while(atomic_load(&group->running))
+    {
+        backlog = 0;
+        task = TakeDue(shard, &backlog);
+
+        if(backlog)
+        {
+            WakeIdle(group, shard);
+        }
+
+        if(!task)
+        {
+            task = Steal(group, shard);
+        }
+
+        if(!task)
+        {
+            task = Sleep(group, shard);
+        }
+
+        if(task)
+        {
+            RunTask(group, shard, task);
+        }
+    }
+
+    return NULL;
+}
+
+static void Pin(const sched_group_t* group, shard_t* shard)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+
+    if(cores < 2 || (size_t)cores < group->count)
+    {
+        return;
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(shard->index, &set);
+    pthread_setaffinity_np(shard->thread, sizeof(set), &set);
+}
+
+/*****************************API Functions************************************/
+
+sched_group_t* SchedGroupCreate(size_t shards)
+{
+    sched_group_t* group = NULL;
+    long cores = 0;
+
+    if(!shards)
+    {
+        cores = sysconf(_SC_NPROCESSORS_ONLN);
+        shards = cores > 0 ? (size_t)cores : 1;
+    }
+
+    group = (sched_group_t*)malloc(sizeof(sched_group_t));
+    if(!group)
+    {
+        return NULL;
+    }
+
+    group->shards = (shard_t**)malloc(shards * sizeof(shard_t*));
+    if(!group->shards)
+    {
+        free(group);
+        return NULL;
+    }
+
+    for(group->count = 0; group->count < shards; ++group->count)
+    {
+        group->shards[group->count] = CreateShard(group, group->count);
+
+        if(!group->shards[group->count])
+        {
+            while(group->count--)
+            {
+                DestroyShard(group->shards[group->count]);
+            }
+
+            free(group->shards);
+            free(group);
+            return NULL;
+        }
+    }
+
+    group->started = 0;
+    atomic_init(&group->running, 0);
+    atomic_init(&group->size, 0);
+
+    return group;
+}
+
+void SchedGroupDestroy(sched_group_t* group)
+{
+    size_t i = 0;
+
+    assert(group);
+
+    SchedGroupStop(group);
+
+    for(; i < group->count; ++i)
+    {
+        DestroyShard(group->shards[i]);
+    }
+
+    free(group->shards);
+    free(group);
+}
+
+ilrd_uid_t SchedGroupAdd(sched_group_t* group,
+                        int (*action_func)(void* params), void* params,
+                        size_t interval_in_sec, size_t key)
+{
+    task_t* task = NULL;
+    shard_t* home = NULL;
+    int failed = 0;
+
+    assert(group);
+    assert(action_func);
+
+    task = TaskCreate(action_func, params, interval_in_sec);
+    if(!task)
+    {
+        return bad_uid;
+    }
+
+    home = group->shards[HomeOf(group, key)];
+    TaskSetSlot(task, home->index);
+
+    pthread_mutex_lock(&home->lock);
+    failed = PQEnqueue(home->queue, task);
+    pthread_cond_signal(&home->wake);
+    pthread_mutex_unlock(&home->lock);
+
+    if(failed)
+    {
+        TaskDestroy(task);
+        return bad_uid;
+    }
+
+    atomic_fetch_add(&group->size, 1);
+
+    return TaskGetUID(task);
+}
+
+int SchedGroupStart(sched_group_t* group)
+{
+    assert(group);
+    assert(!group->started);
+
+    atomic_store(&group->running, 1);
+
+    for(; group->started < group->count; ++group->started)
+    {
+        shard_t* shard = group->shards[group->started];
+
+        if(pthread_create(&shard->thread, NULL, ShardMain, shard))
+        {
+            SchedGroupStop(group);
+            return 1;
+        }
+
+        Pin(group, shard);
+    }
+
+    return 0;
+}
+
+void SchedGroupStop(sched_group_t* group)
+{
+    size_t i = 0;
+
+    assert(group);
+
+    atomic_store(&group->running, 0);
+
+    for(i = 0; i < group->started; ++i)
+    {
+        Signal(group->shards[i]);
+    }
+
+    for(i = 0; i < group->started; ++i)
+    {
+        pthread_join(group->shards[i]->thread, NULL);
+    }
+
+    group->started = 0;
+}
+
+size_t SchedGroupSize(const sched_group_t* group)
+{
+    assert(group);
+
+    return atomic_load(&((sched_group_t*)group)->size);
+}
+
+size_t SchedGroupStats(const sched_group_t* group, sched_shard_stats_t* stats,
+                                                                size_t max)
+{
+    size_t i = 0;
+
+    assert(group);
+    assert(stats || !max);
+
+    for(; i < group->count && i < max; ++i)
+    {
+        shard_t* shard = group->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        stats[i].tasks = PQSize(shard->queue);
+        pthread_mutex_unlock(&shard->lock);
+
+        stats[i].runs = atomic_load_explicit(&shard->runs,
+                                                    memory_order_relaxed);
+        stats[i].steals = atomic_load_explicit(&shard->steals,
+                                                    memory_order_relaxed);
+    }
+
+    return i;
+}
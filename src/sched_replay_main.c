@@ -0,0 +1,660 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf, fopen, fread, fseek, ftell, fclose */
+#include <stdlib.h>     /* malloc, free, qsort */
+#include <string.h>     /* strcmp */
+#include <time.h>       /* clock_gettime */
+
+#include "heap_pq.h"
+#include "multi_pq.h"
+#include "heap_scheduler.h"
+#include "sched_clock.h"
+#include "sched_trace.h"
+
+#define NONE ((size_t)-1)
+#define MPQ_QUEUES (4)
+#define START_TIME (1000000000)
+#define FEED_INTERVAL (1)
+
+/*
+*   Every add starts an instance, which lives until its remove or its run
+*   with @result set. Instances are what both replays work on, the slots
+*   of the trace are reused
+*/
+typedef struct instance
+{
+    size_t interval;
+    int lane;
+    size_t first_run;
+    size_t next_run;
+    sched_handle_t handle;
+    int added;
+    struct replay* replay;
+} instance_t;
+
+typedef struct replay
+{
+    sched_trace_record_t* records;
+    size_t* instance_of;
+    size_t* next_run;
+    size_t count;
+    instance_t* instances;
+    size_t instances_count;
+    unsigned long* samples;
+    size_t samples_count;
+    size_t samples_capacity;
+    size_t runs;
+    size_t recorded_runs;
+    size_t cursor;
+    double last_exit;
+    sched_clock_t* clock;
+    scheduler_t* scheduler;
+} replay_t;
+
+/* one queued instance, a remove marks it dead and it's skipped once popped */
+typedef struct item
+{
+    unsigned long key;
+    size_t instance;
+    int dead;
+} item_t;
+
+typedef struct queue
+{
+    void* pq;
+    int (*enqueue)(void* pq, void* data);
+    void* (*dequeue)(void* pq);
+    void (*destroy)(void* pq);
+} queue_t;
+
+typedef enum backend
+{
+    PQ_BINARY    = 0,
+    PQ_RADIX     = 1,
+    PQ_MULTI     = 2,
+    SCHED_BINARY = 3,
+    SCHED_RADIX  = 4,
+    BACKENDS     = 5
+} backend_t;
+
+static const char* const names[BACKENDS] =
+{
+    "pq-binary", "pq-radix", "pq-multi", "sched-binary", "sched-radix"
+};
+
+/*****************************Helper Functions*********************************/
+
+static double NowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void Sample(replay_t* replay, double start, double end)
+{
+    if (replay->samples_count < replay->samples_capacity)
+    {
+        replay->samples[replay->samples_count++] =
+                                    (unsigned long)((end - start) * 1e9);
+    }
+}
+
+static int CompareSample(const void* one, const void* other)
+{
+    unsigned long a = *(const unsigned long*)one;
+    unsigned long b = *(const unsigned long*)other;
+
+    return (a > b) - (a < b);
+}
+
+static void Report(replay_t* replay, const char* name, const char* unit,
+                                                size_t ops, double elapsed)
+{
+    unsigned long* samples = replay->samples;
+    size_t count = replay->samples_count;
+
+    qsort(samples, count, sizeof(unsigned long), CompareSample);
+
+    printf("%-13s %10lu %-5s %8.3f s %12.0f %s/s", name, (unsigned long)ops,
+                    unit, elapsed, elapsed > 0 ? ops / elapsed : 0.0, unit);
+    if (count > 0)
+    {
+        printf("   p50 %5lu ns  p99 %6lu ns  max %8lu ns",
+                    samples[count / 2], samples[count - count / 100 - 1],
+                    samples[count - 1]);
+    }
+    printf("\n");
+}
+
+/******************************Trace Loading***********************************/
+
+static int Load(replay_t* replay, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    sched_trace_header_t header;
+    long size = 0;
+
+    if (file == NULL)
+    {
+        return 1;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+                        header.magic != SCHED_TRACE_MAGIC ||
+                        header.version != SCHED_TRACE_VERSION ||
+                        header.record_size != sizeof(sched_trace_record_t))
+    {
+        fclose(file);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file) - (long)sizeof(header);
+    fseek(file, (long)sizeof(header), SEEK_SET);
+
+    replay->count = (size_t)size / sizeof(sched_trace_record_t);
+    replay->records = (sched_trace_record_t*)malloc(replay->count *
+                                    sizeof(sched_trace_record_t) + 1);
+    if (replay->records == NULL || fread(replay->records,
+            sizeof(sched_trace_record_t), replay->count, file) != replay->count)
+    {
+        fclose(file);
+        return 1;
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+/* links every record to its instance and every run to the next one */
+static int Index(replay_t* replay)
+{
+    sched_trace_record_t* record = NULL;
+    instance_t* instance = NULL;
+    size_t* current = NULL;
+    size_t* last_run = NULL;
+    size_t slots = 1;
+    size_t i = 0;
+
+    for (i = 0; i < replay->count; ++i)
+    {
+        if (replay->records[i].task >= slots)
+        {
+            slots = replay->records[i].task + 1;
+        }
+    }
+
+    current = (size_t*)malloc(slots * sizeof(size_t));
+    replay->instance_of = (size_t*)malloc(replay->count * sizeof(size_t) + 1);
+    replay->next_run = (size_t*)malloc(replay->count * sizeof(size_t) + 1);
+    replay->instances = (instance_t*)malloc(replay->count *
+                                                    sizeof(instance_t) + 1);
+    last_run = (size_t*)malloc(replay->count * sizeof(size_t) + 1);
+    if (current == NULL || replay->instance_of == NULL ||
+        replay->next_run == NULL || replay->instances == NULL ||
+                                                            last_run == NULL)
+    {
+        free(current);
+        free(last_run);
+        return 1;
+    }
+
+    for (i = 0; i < slots; ++i)
+    {
+        current[i] = NONE;
+    }
+
+    for (i = 0; i < replay->count; ++i)
+    {
+        record = replay->records + i;
+        replay->next_run[i] = NONE;
+
+        if (record->event == TRACE_ADD)
+        {
+            current[record->task] = replay->instances_count;
+            instance = replay->instances + replay->instances_count;
+            instance->interval = record->value;
+            instance->lane = record->lane;
+            instance->first_run = NONE;
+            instance->replay = replay;
+            last_run[replay->instances_count++] = NONE;
+        }
+
+        replay->instance_of[i] = record->event == TRACE_STOP ? NONE :
+                                                        current[record->task];
+        if (replay->instance_of[i] == NONE)
+        {
+            continue;
+        }
+
+        if (record->event == TRACE_RUN)
+        {
+            instance = replay->instances + replay->instance_of[i];
+            if (last_run[replay->instance_of[i]] == NONE)
+            {
+                instance->first_run = i;
+            }
+            else
+            {
+                replay->next_run[last_run[replay->instance_of[i]]] = i;
+            }
+            last_run[replay->instance_of[i]] = i;
+            ++replay->recorded_runs;
+        }
+
+        if (record->event == TRACE_REMOVE ||
+                        (record->event == TRACE_RUN && record->result))
+        {
+            current[record->task] = NONE;
+        }
+    }
+
+    free(current);
+    free(last_run);
+
+    return 0;
+}
+
+/*******************************PQ Replay**************************************/
+
+static int CompareItem(const void* one, const void* other)
+{
+    unsigned long a = ((const item_t*)one)->key;
+    unsigned long b = ((const item_t*)other)->key;
+
+    return (a > b) - (a < b);
+}
+
+static unsigned long ItemKey(const void* item)
+{
+    return ((const item_t*)item)->key;
+}
+
+static int HeapEnqueue(void* pq, void* data)
+{
+    return PQEnqueue((heap_pq_t*)pq, data);
+}
+
+static void* HeapDequeue(void* pq)
+{
+    return PQDequeue((heap_pq_t*)pq);
+}
+
+static void HeapDestroy(void* pq)
+{
+    PQDestroy((heap_pq_t*)pq);
+}
+
+static int MultiEnqueue(void* pq, void* data)
+{
+    return MPQEnqueue((multi_pq_t*)pq, data);
+}
+
+static void* MultiDequeue(void* pq)
+{
+    return MPQDequeue((multi_pq_t*)pq);
+}
+
+static void MultiDestroy(void* pq)
+{
+    MPQDestroy((multi_pq_t*)pq);
+}
+
+static int CreateQueue(queue_t* queue, backend_t backend)
+{
+    queue->enqueue = HeapEnqueue;
+    queue->dequeue = HeapDequeue;
+    queue->destroy = HeapDestroy;
+
+    switch (backend)
+    {
+        case PQ_BINARY:
+            queue->pq = PQCreate(CompareItem);
+            break;
+        case PQ_RADIX:
+            queue->pq = PQCreateRadix(ItemKey);
+            break;
+        default:
+            queue->pq = MPQCreate(MPQ_QUEUES, ItemKey);
+            queue->enqueue = MultiEnqueue;
+            queue->dequeue = MultiDequeue;
+            queue->destroy = MultiDestroy;
+            break;
+    }
+
+    return queue->pq == NULL;
+}
+
+/*
+*   A run pops the earliest live item. Deadlines are whole seconds, so that
+*   is often another instance due the same second than the one the trace
+*   ran. The two then trade items, which keeps every instance queued at its
+*   own deadline, and the trade is counted as a reorder
+*/
+static size_t RunItem(replay_t* replay, queue_t* queue, item_t** item_of,
+                                        const sched_trace_record_t* record,
+                                        size_t instance)
+{
+    item_t* item = NULL;
+    item_t* own = item_of[instance];
+    size_t reordered = 0;
+
+    do
+    {
+        item = (item_t*)queue->dequeue(queue->pq);
+    }
+    while (item != NULL && item->dead);
+
+    if (item == NULL)
+    {
+        return 0;
+    }
+
+    if (item != own)
+    {
+        own->instance = item->instance;
+        item_of[item->instance] = own;
+        item->instance = instance;
+        item_of[instance] = item;
+        reordered = 1;
+    }
+
+    if (!record->result)
+    {
+        item->key = record->usec / 1000000 +
+                                    replay->instances[instance].interval;
+        queue->enqueue(queue->pq, item);
+    }
+
+    return reordered;
+}
+
+static int ReplayQueue(replay_t* replay, backend_t backend)
+{
+    item_t* items = (item_t*)malloc(replay->instances_count *
+                                                        sizeof(item_t) + 1);
+    item_t** item_of = (item_t**)malloc(replay->instances_count *
+                                                        sizeof(item_t*) + 1);
+    const sched_trace_record_t* record = NULL;
+    size_t reordered = 0;
+    size_t instance = 0;
+    size_t i = 0;
+    double start = 0;
+    double last = 0;
+    double now = 0;
+    queue_t queue;
+
+    if (items == NULL || item_of == NULL || CreateQueue(&queue, backend))
+    {
+        free(items);
+        free(item_of);
+        return 1;
+    }
+
+    replay->samples_count = 0;
+    start = NowSec();
+    last = start;
+
+    for (; i < replay->count; ++i)
+    {
+        record = replay->records + i;
+        instance = replay->instance_of[i];
+        if (instance == NONE)
+        {
+            continue;
+        }
+
+        switch (record->event)
+        {
+            case TRACE_ADD:
+                items[instance].key = record->usec / 1000000 +
+                                        replay->instances[instance].interval;
+                items[instance].instance = instance;
+                items[instance].dead = 0;
+                item_of[instance] = items + instance;
+                queue.enqueue(queue.pq, items + instance);
+                break;
+            case TRACE_REMOVE:
+                item_of[instance]->dead = 1;
+                break;
+            case TRACE_RUN:
+                reordered += RunItem(replay, &queue, item_of, record,
+                                                                instance);
+                break;
+            default:
+                break;
+        }
+
+        now = NowSec();
+        Sample(replay, last, now);
+        last = now;
+    }
+
+    Report(replay, names[backend], "ops", replay->samples_count, now - start);
+    printf("%-13s %10lu runs popped another instance due the same second\n",
+                                        "", (unsigned long)reordered);
+
+    queue.destroy(queue.pq);
+    free(items);
+    free(item_of);
+
+    return 0;
+}
+
+/****************************Scheduler Replay**********************************/
+
+/* replays the recorded run time and result of the instance's next run */
+static int Action(void* params)
+{
+    instance_t* instance = (instance_t*)params;
+    replay_t* replay = instance->replay;
+    const sched_trace_record_t* record = NULL;
+    double entry = NowSec();
+
+    Sample(replay, replay->last_exit, entry);
+    ++replay->runs;
+
+    if (instance->next_run != NONE)
+    {
+        record = replay->records + instance->next_run;
+        instance->next_run = replay->next_run[instance->next_run];
+        ClockAdvance(replay->clock, record->value);
+    }
+
+    replay->last_exit = NowSec();
+
+    return record != NULL && record->result;
+}
+
+/* applies the adds and removes that are due, stops after the last record */
+static int Feed(void* params)
+{
+    replay_t* replay = (replay_t*)params;
+    const sched_trace_record_t* record = NULL;
+    instance_t* instance = NULL;
+    unsigned long now = (unsigned long)(ClockTime(replay->clock) - START_TIME);
+
+    for (; replay->cursor < replay->count; ++replay->cursor)
+    {
+        record = replay->records + replay->cursor;
+        if (record->usec / 1000000 > now)
+        {
+            break;
+        }
+
+        if (replay->instance_of[replay->cursor] == NONE)
+        {
+            continue;
+        }
+
+        instance = replay->instances + replay->instance_of[replay->cursor];
+        if (record->event == TRACE_ADD)
+        {
+            instance->next_run = instance->first_run;
+            instance->added = !UIDIsSame(bad_uid,
+                        SchedulerAddEx(replay->scheduler, Action, instance,
+                                instance->interval,
+                                (sched_priority_t)instance->lane, NULL,
+                                &instance->handle));
+        }
+        else if (record->event == TRACE_REMOVE && instance->added)
+        {
+            SchedulerCancel(replay->scheduler, instance->handle);
+        }
+    }
+
+    if (replay->cursor == replay->count &&
+                replay->records[replay->count - 1].usec / 1000000 <= now)
+    {
+        SchedulerStop(replay->scheduler);
+        return 1;
+    }
+
+    replay->last_exit = NowSec();
+
+    return 0;
+}
+
+static int ReplayScheduler(replay_t* replay, backend_t backend)
+{
+    double start = 0;
+    size_t i = 0;
+
+    replay->clock = ClockCreateSimulated(START_TIME);
+    replay->scheduler = SchedulerCreateBackend(backend == SCHED_RADIX ?
+                                        SCHED_RADIX_HEAP : SCHED_BINARY_HEAP);
+    if (replay->clock == NULL || replay->scheduler == NULL)
+    {
+        SchedulerDestroy(replay->scheduler);
+        ClockDestroy(replay->clock);
+        return 1;
+    }
+
+    SchedulerSetClock(replay->scheduler, replay->clock);
+    for (; i < replay->instances_count; ++i)
+    {
+        replay->instances[i].added = 0;
+    }
+    replay->cursor = 0;
+    replay->runs = 0;
+    replay->samples_count = 0;
+
+    if (UIDIsSame(bad_uid, SchedulerAddEx(replay->scheduler, Feed, replay,
+                                FEED_INTERVAL, SCHED_CRITICAL, NULL, NULL)))
+    {
+        SchedulerDestroy(replay->scheduler);
+        ClockDestroy(replay->clock);
+        return 1;
+    }
+
+    start = NowSec();
+    replay->last_exit = start;
+    Feed(replay);
+    SchedulerRun(replay->scheduler);
+
+    Report(replay, names[backend], "runs", replay->runs, NowSec() - start);
+    printf("%-13s %10lu runs recorded, dispatch latency is between runs\n",
+                                    "", (unsigned long)replay->recorded_runs);
+
+    SchedulerDestroy(replay->scheduler);
+    ClockDestroy(replay->clock);
+
+    return 0;
+}
+
+/*********************************Main*****************************************/
+
+static void Usage(const char* name)
+{
+    printf("usage: %s <trace> [pq-binary|pq-radix|pq-multi|"
+                                        "sched-binary|sched-radix]...\n", name);
+}
+
+static int Backend(const char* name)
+{
+    int backend = 0;
+
+    for (; backend < BACKENDS; ++backend)
+    {
+        if (strcmp(name, names[backend]) == 0)
+        {
+            break;
+        }
+    }
+
+    return backend;
+}
+
+static void Release(replay_t* replay)
+{
+    free(replay->samples);
+    free(replay->instances);
+    free(replay->next_run);
+    free(replay->instance_of);
+    free(replay->records);
+}
+
+int main(int argc, char* argv[])
+{
+    replay_t replay = {0};
+    int selected[BACKENDS] = {0};
+    int status = 0;
+    int backend = 0;
+    int i = 2;
+
+    for (; i < argc; ++i)
+    {
+        backend = Backend(argv[i]);
+        if (backend == BACKENDS)
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+        selected[backend] = 1;
+    }
+
+    if (argc < 2)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    if (Load(&replay, argv[1]) != 0 || Index(&replay) != 0)
+    {
+        fprintf(stderr, "%s: can't read trace %s\n", argv[0], argv[1]);
+        Release(&replay);
+        return 1;
+    }
+
+    replay.samples_capacity = replay.count + 1;
+    replay.samples = (unsigned long*)malloc(replay.samples_capacity *
+                                                        sizeof(unsigned long));
+    if (replay.samples == NULL)
+    {
+        Release(&replay);
+        return 1;
+    }
+
+    printf("%lu records, %lu tasks, %lu runs, %.1f s recorded\n",
+            (unsigned long)replay.count, (unsigned long)replay.instances_count,
+            (unsigned long)replay.recorded_runs, replay.count > 0 ?
+            replay.records[replay.count - 1].usec / 1e6 : 0.0);
+
+    for (backend = 0; backend < BACKENDS; ++backend)
+    {
+        if (argc == 2 || selected[backend])
+        {
+            status |= backend < SCHED_BINARY ?
+                                ReplayQueue(&replay, (backend_t)backend) :
+                                ReplayScheduler(&replay, (backend_t)backend);
+        }
+    }
+
+    Release(&replay);
+
+    return status;
+}
@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>     /* assert */
+#include <stdlib.h>     /* malloc, free */
+#include <unistd.h>     /* ftruncate, close, unlink */
+#include <fcntl.h>      /* open, O_RDWR, O_CREAT */
+#include <sys/mman.h>   /* mmap, munmap */
+#include <sys/stat.h>   /* fstat */
+#include <string.h>     /* strlen, strcpy */
+#include <time.h>       /* time */
+#include <stdatomic.h>  /* atomic_signal_fence */
+
+#include "sched_snapshot.h"
+
+#define SNAPSHOT_MAGIC (0x57445331UL)
+
+typedef struct snapshot_record
+{
+    size_t action;
+    sched_task_info_t info;
+} snapshot_record_t;
+
+/*
+*   @seq is odd while a save is in progress. A crash leaves the shared
+*   mapping as the stores left it, so only the compiler order needs fencing
+*/
+typedef struct snapshot_file
+{
+    unsigned long magic;
+    volatile unsigned long seq;
+    time_t saved_at;
+    size_t count;
+    snapshot_record_t records[SNAPSHOT_MAX_TASKS];
+} snapshot_file_t;
+
+struct sched_snapshot
+{
+    snapshot_file_t* file;
+    const task_action_t* actions;
+    size_t count;
+    char* path;
+};
+
+/**********************Static Functions Implementation*************************/
+
+static size_t ActionIndex(const sched_snapshot_t* snapshot,
+                                                    task_action_t action_func)
+{
+    size_t i = 0;
+
+    while(i < snapshot->count && snapshot->actions[i] != action_func)
+    {
+        ++i;
+    }
+
+    return i;
+}
+
+static snapshot_file_t* MapFile(const char* path)
+{
+    snapshot_file_t* file = NULL;
+    struct stat info;
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+
+    if(-1 == fd)
+    {
+        return NULL;
+    }
+
+    if(-1 == fstat(fd, &info) || ((size_t)info.st_size < sizeof(*file) &&
+                                        -1 == ftruncate(fd, sizeof(*file))))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    file = (snapshot_file_t*)mmap(NULL, sizeof(*file), PROT_READ | PROT_WRITE,
+                                                        MAP_SHARED, fd, 0);
+    close(fd);
+
+    return MAP_FAILED == file ? NULL : file;
+}
+
+/*****************************API Functions************************************/
+
+sched_snapshot_t* SnapshotOpen(const char* path, const task_action_t* actions,
+                                                                size_t count)
+{
+    sched_snapshot_t* snapshot = NULL;
+
+    assert(path);
+    assert(actions || !count);
+
+    snapshot = (sched_snapshot_t*)malloc(sizeof(sched_snapshot_t));
+    if(!snapshot)
+    {
+        return NULL;
+    }
+
+    snapshot->path = (char*)malloc(strlen(path) + 1);
+    if(!snapshot->path)
+    {
+        free(snapshot);
+        return NULL;
+    }
+
+    snapshot->file = MapFile(path);
+    if(!snapshot->file)
+    {
+        free(snapshot->path);
+        free(snapshot);
+        return NULL;
+    }
+
+    strcpy(snapshot->path, path);
+    snapshot->actions = actions;
+    snapshot->count = count;
+
+    return snapshot;
+}
+
+void SnapshotClose(sched_snapshot_t* snapshot, int remove)
+{
+    if(!snapshot)
+    {
+        return;
+    }
+
+    munmap(snapshot->file, sizeof(*snapshot->file));
+
+    if(remove)
+    {
+        unlink(snapshot->path);
+    }
+
+    free(snapshot->path);
+    free(snapshot);
+}
+
+size_t SnapshotSave(sched_snapshot_t* snapshot, const scheduler_t* scheduler)
+{
+    sched_task_info_t infos[SNAPSHOT_MAX_TASKS];
+    snapshot_file_t* file = NULL;
+    size_t found = 0;
+    size_t index = 0;
+    size_t i = 0;
+
+    assert(snapshot);
+    assert(scheduler);
+
+    file = snapshot->file;
+    found = SchedulerSnapshot(scheduler, infos, SNAPSHOT_MAX_TASKS);
+
+    file->seq |= 1;
+    atomic_signal_fence(memory_order_seq_cst);
+    file->count = 0;
+
+    for(; i < found; ++i)
+    {
+        index = ActionIndex(snapshot, infos[i].action_func);
+
+        if(index < snapshot->count)
+        {
+            file->records[file->count].action = index;
+            file->records[file->count].info = infos[i];
+            ++file->count;
+        }
+    }
+
+    file->magic = SNAPSHOT_MAGIC;
+    file->saved_at = time(NULL);
+    atomic_signal_fence(memory_order_seq_cst);
+    ++file->seq;
+
+    return file->count;
+}
+
+size_t SnapshotRestore(const sched_snapshot_t* snapshot,
+                                scheduler_t* scheduler, size_t max_age_sec)
+{
+    sched_task_info_t infos[SNAPSHOT_MAX_TASKS];
+    int used[SNAPSHOT_MAX_TASKS] = {0};
+    const snapshot_file_t* file = NULL;
+    sched_task_info_t saved;
+    time_t now = time(NULL);
+    size_t restored = 0;
+    size_t found = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    assert(snapshot);
+    assert(scheduler);
+
+    file = snapshot->file;
+
+    if(SNAPSHOT_MAGIC != file->magic || (file->seq & 1) ||
+                file->count > SNAPSHOT_MAX_TASKS || file->saved_at > now ||
+                (size_t)(now - file->saved_at) > max_age_sec)
+    {
+        return 0;
+    }
+
+    found = SchedulerSnapshot(scheduler, infos, SNAPSHOT_MAX_TASKS);
+
+    for(; i < file->count; ++i)
+    {
+        if(file->records[i].action >= snapshot->count)
+        {
+            continue;
+        }
+
+        for(j = 0; j < found; ++j)
+        {
+            if(!used[j] && infos[j].action_func ==
+                                snapshot->actions[file->records[i].action])
+            {
+                break;
+            }
+        }
+
+        if(j == found)
+        {
+            continue;
+        }
+
+        saved = file->records[i].info;
+        if(saved.time_to_run > now + (time_t)saved.interval_in_sec)
+        {
+            saved.time_to_run = now + saved.interval_in_sec;
+        }
+
+        used[j] = 1;
+        restored += !SchedulerRestoreTask(scheduler, infos[j].handle, &saved);
+    }
+
+    return restored;
+}
@@ -1,10 +1,13 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>     /* assert */
-#include <time.h> 	/* time_t */
+#include <time.h> 	/* time_t, time */
 #include <stdlib.h>	/* malloc, free */
-#include <unistd.h> 	/* sleep */
 
 #include "ilrd_uid.h"
 #include "task.h"
+#include "sched_clock.h"
+#include "wd_trace.h"
 
 struct task
 {
@@ -13,6 +16,10 @@ struct task
     void* params;
     size_t interval_in_sec;
     time_t time_to_run;
+    size_t slot;
+    size_t run_usec;
+    task_stats_t stats;
+    const sched_clock_t* clock;
 };
 
 task_t* TaskCreate(int (*action_func)(void* params), void* params,
@@ -38,6 +45,13 @@ task_t* TaskCreate(int (*action_func)(void* params), void* params,
     task->params = params;
     task->interval_in_sec = interval_in_sec;
     task->time_to_run = time(NULL) + interval_in_sec;
+    task->clock = NULL;
+    task->slot = 0;
+    task->run_usec = 0;
+    task->stats.run_count = 0;
+    task->stats.total_run_usec = 0;
+    task->stats.max_run_usec = 0;
+    task->stats.max_late_usec = 0;
 	
     return task;
 }
@@ -49,17 +63,38 @@ void TaskDestroy(task_t* task)
 
 int TaskRun(task_t* task)
 {
-    time_t sleep_time = 0;
+    struct timespec due;
+    struct timespec start;
+    struct timespec end;
+    long late_usec = 0;
+    int result = 0;
     assert(task);
 	
-    sleep_time = task->time_to_run - time(NULL);
-    while (sleep_time > 0)
+    ClockRealtime(task->clock, &due);
+    late_usec = (due.tv_sec - task->time_to_run) * 1000000 +
+                                                        due.tv_nsec / 1000;
+    WD_TRACE2(task_run_start, task->uid.counter, late_usec);
+
+    ClockMonotonic(task->clock, &start);
+    result = task->action_func(task->params);
+    ClockMonotonic(task->clock, &end);
+
+    task->run_usec = (end.tv_sec - start.tv_sec) * 1000000 +
+                                    (end.tv_nsec - start.tv_nsec) / 1000;
+    WD_TRACE3(task_run_end, task->uid.counter, task->run_usec, result);
+
+    ++task->stats.run_count;
+    task->stats.total_run_usec += task->run_usec;
+    if (task->run_usec > task->stats.max_run_usec)
     {
-      	sleep(sleep_time);
-      	sleep_time = task->time_to_run - time(NULL);
+        task->stats.max_run_usec = task->run_usec;
     }
-	
-    return task->action_func(task->params);
+    if (late_usec > 0 && (size_t)late_usec > task->stats.max_late_usec)
+    {
+        task->stats.max_late_usec = late_usec;
+    }
+
+    return result;
 }
 
 ilrd_uid_t TaskGetUID(const task_t* task)
@@ -87,7 +122,75 @@ void TaskSetTimeToRun(task_t* task)
 {
     assert(task);
 	
-    task->time_to_run = time(NULL) + task->interval_in_sec;
+    task->time_to_run = ClockTime(task->clock) + task->interval_in_sec;
+}
+
+void TaskSetInterval(task_t* task, size_t interval_in_sec)
+{
+    assert(task);
+
+    task->interval_in_sec = interval_in_sec;
+    task->time_to_run = ClockTime(task->clock) + interval_in_sec;
+}
+
+void TaskSetClock(task_t* task, const sched_clock_t* clock)
+{
+    assert(task);
+
+    task->clock = clock;
+    task->time_to_run = ClockTime(clock) + task->interval_in_sec;
+}
+
+size_t TaskGetRunTime(const task_t* task)
+{
+    assert(task);
+
+    return task->run_usec;
+}
+
+task_action_t TaskGetAction(const task_t* task)
+{
+    assert(task);
+
+    return task->action_func;
+}
+
+void TaskRestore(task_t* task, time_t time_to_run, const task_stats_t* stats)
+{
+    assert(task);
+    assert(stats);
+
+    task->time_to_run = time_to_run;
+    task->stats = *stats;
+}
+
+void TaskShift(task_t* task, long delta_sec)
+{
+    assert(task);
+
+    task->time_to_run += delta_sec;
+}
+
+void TaskGetStats(const task_t* task, task_stats_t* stats)
+{
+    assert(task);
+    assert(stats);
+
+    *stats = task->stats;
+}
+
+size_t TaskGetSlot(const task_t* task)
+{
+    assert(task);
+
+    return task->slot;
+}
+
+void TaskSetSlot(task_t* task, size_t slot)
+{
+    assert(task);
+
+    task->slot = slot;
 }
 
 int TaskIsEqual(const task_t* task1, const task_t* task2)
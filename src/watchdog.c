@@ -9,18 +9,38 @@
 #include <fcntl.h>      /* O_CREAT */
 #include <assert.h>     /* assert */
 #include <sys/wait.h>   /* waitpid */
+#include <sys/socket.h> /* socketpair */
+#include <stdatomic.h>  /* atomic_int */
 
 #include "watchdog.h"
 #include "inner_watchdog.h"
+#include "wd_state.h"
+#include "wd_fds.h"
 
 #define TOTAL_INPUT_TO_EXCPECT (5)
 
+typedef struct async_start
+{
+    size_t threshold;
+    size_t interval;
+    int argc;
+    char** argv;
+    wd_ready_t on_ready;
+    void* param;
+} async_start_t;
+
 size_t g_threshold;
 size_t g_interval;
 int g_argc;
 pid_t pid;
 pthread_t thread;
 
+static async_start_t async_start;
+static pthread_t start_thread;
+static int start_pending;
+static int in_process;
+static atomic_int is_ready;
+
 /**********************Static Functions Implementation*************************/
 
 static void* ThreadStart(void* args)
@@ -36,6 +56,27 @@ static void* ThreadStart(void* args)
     return NULL;
 }
 
+static void* InProcessStart(void* args)
+{
+    RunWD(g_threshold, g_interval, g_argc, (char**)args, INPROC);
+
+    return NULL;
+}
+
+static void* AsyncStart(void* args)
+{
+    async_start_t* start = (async_start_t*)args;
+    wd_status_t status = StartWD(start->threshold, start->interval,
+                                                    start->argc, start->argv);
+
+    if(start->on_ready)
+    {
+        start->on_ready(status, start->param);
+    }
+
+    return NULL;
+}
+
 static void CleanResources(sem_t* sem, char** args)
 {
     free(args);
@@ -43,6 +84,12 @@ static void CleanResources(sem_t* sem, char** args)
     sem_unlink(SEM_NAME);
 }
 
+static void CloseSockets(int* sockets)
+{
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
 static char** CreateExecArgsInput(char* threshold, char* interval, char* argc,
                                                                     char** argv)
 {
@@ -81,7 +128,9 @@ wd_status_t StartWD(size_t threshold, size_t interval, int argc, char** argv)
     char interval_buffer[BUFSIZE];
     char argc_buffer[BUFSIZE];
     char pid_buffer[BUFSIZE];
+    char socket_buffer[BUFSIZE];
     char** exec_args = NULL;
+    int sockets[2];
     sem_t* sem;
 
     assert(threshold != 0);
@@ -106,10 +155,28 @@ wd_status_t StartWD(size_t threshold, size_t interval, int argc, char** argv)
         return WD_FAILED;
     }
 
+    /* [0] stays with the client, [1] is inherited by the watchdog process */
+    if(-1 == socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets))
+    {
+        CleanResources(sem, exec_args);
+        return WD_FAILED;
+    }
+
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    sprintf(socket_buffer, "%d", sockets[1]);
+
+    if(-1 == setenv(SOCKET_ENV_NAME, socket_buffer, 1))
+    {
+        CloseSockets(sockets);
+        CleanResources(sem, exec_args);
+        return WD_FAILED;
+    }
+
     pid = fork();
 
     if(-1 == pid)
     {
+        CloseSockets(sockets);
         CleanResources(sem, exec_args);
         return WD_FAILED;
     }
@@ -123,10 +190,13 @@ wd_status_t StartWD(size_t threshold, size_t interval, int argc, char** argv)
         }
     }
     
+    close(sockets[1]);
+    unsetenv(SOCKET_ENV_NAME);
     sprintf(pid_buffer, "%d" ,pid);
     
     if(-1 == setenv(ENV_VAR_NAME, pid_buffer, 1))
     {
+        close(sockets[0]);
         CleanResources(sem, exec_args);
         return WD_FAILED;
     }
@@ -136,21 +206,160 @@ wd_status_t StartWD(size_t threshold, size_t interval, int argc, char** argv)
     if(0 != pthread_create(&thread, NULL, ThreadStart, argv))
     {
         kill(pid, SIGUSR2);
+        close(sockets[0]);
         CleanResources(sem, exec_args);
         return WD_FAILED;
     }
 
     sem_wait(sem);
     CleanResources(sem, exec_args);
+    FdsConnect(sockets[0]);
+    atomic_store(&is_ready, 1);
+
+    return WD_SUCCESS;
+}
+
+wd_status_t StartWDAsync(size_t threshold, size_t interval, int argc,
+                            char** argv, wd_ready_t on_ready, void* param)
+{
+    assert(threshold != 0);
+    assert(interval != 0);
+
+    async_start.threshold = threshold;
+    async_start.interval = interval;
+    async_start.argc = argc;
+    async_start.argv = argv;
+    async_start.on_ready = on_ready;
+    async_start.param = param;
+
+    if(0 != pthread_create(&start_thread, NULL, AsyncStart, &async_start))
+    {
+        return WD_FAILED;
+    }
+
+    start_pending = 1;
+
+    return WD_SUCCESS;
+}
+
+int WDIsReady(void)
+{
+    return atomic_load(&is_ready);
+}
+
+wd_status_t StartWDInProcess(size_t threshold, size_t interval, int argc,
+                char** argv, wd_action_t action, wd_hook_t hook, void* param)
+{
+    assert(threshold != 0);
+    assert(interval != 0);
+
+    g_threshold = threshold;
+    g_interval = interval;
+    g_argc = argc;
+    InProcessInit(action, hook, param);
+
+    if(0 != pthread_create(&thread, NULL, InProcessStart, argv))
+    {
+        return WD_FAILED;
+    }
+
+    if(-1 == InProcessWait())
+    {
+        pthread_join(thread, NULL);
+        return WD_FAILED;
+    }
+
+    in_process = 1;
+    atomic_store(&is_ready, 1);
+
+    return WD_SUCCESS;
+}
+
+wd_status_t WDSetBudget(const wd_budget_t* budget)
+{
+    char budget_buffer[BUFSIZE];
+
+    assert(budget);
+
+    sprintf(budget_buffer, "%lu:%lu:%lu:%lu", budget->max_rss_kb,
+            budget->max_fds, budget->max_cpu_percent, budget->breach_samples);
+
+    if(-1 == setenv(BUDGET_ENV_NAME, budget_buffer, 1))
+    {
+        return WD_FAILED;
+    }
+
+    return WD_SUCCESS;
+}
+
+wd_status_t WDSetTransport(wd_transport_t transport)
+{
+    char transport_buffer[BUFSIZE];
+
+    sprintf(transport_buffer, "%d", (int)transport);
+
+    if(-1 == setenv(TRANSPORT_ENV_NAME, transport_buffer, 1))
+    {
+        return WD_FAILED;
+    }
+
+    return WD_SUCCESS;
+}
+
+wd_status_t WDSetRealtime(const wd_rt_t* rt)
+{
+    char rt_buffer[BUFSIZE];
+
+    assert(rt);
+
+    sprintf(rt_buffer, "%d:%d", rt->cpu, rt->priority);
+
+    if(-1 == setenv(RT_ENV_NAME, rt_buffer, 1))
+    {
+        return WD_FAILED;
+    }
 
     return WD_SUCCESS;
 }
 
 void StopWD(void)
 {
+    pthread_t stopped;
+
+    if(start_pending)
+    {
+        pthread_join(start_thread, NULL);
+        start_pending = 0;
+    }
+
+    ReviveLock();
+
+    if(!atomic_exchange(&is_ready, 0))
+    {
+        ReviveUnlock();
+        return;
+    }
+
+    if(in_process)
+    {
+        ReviveUnlock();
+        InProcessStop();
+        pthread_join(thread, NULL);
+        in_process = 0;
+        unsetenv(CONFIG_ENV_NAME);
+        StateDiscardAll();
+        return;
+    }
+
     kill(pid, SIGUSR2);
     waitpid(pid, NULL, 0);
     raise(SIGUSR2);
-    pthread_join(thread, NULL);
+
+    /* a revival waiting out its backoff sees the stop and returns */
+    stopped = thread;
+    ReviveUnlock();
+    pthread_join(stopped, NULL);
     unsetenv(ENV_VAR_NAME);
+    unsetenv(CONFIG_ENV_NAME);
+    StateDiscardAll();
 }
\ No newline at end of file
@@ -0,0 +1,313 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <sys/socket.h> /* socket, bind, listen, accept, send, recv */
+#include <sys/un.h>     /* sockaddr_un */
+#include <sys/time.h>   /* timeval */
+#include <unistd.h>     /* read, close, unlink */
+#include <fcntl.h>      /* fcntl, O_NONBLOCK, FD_CLOEXEC */
+#include <poll.h>       /* poll */
+#include <stdlib.h>     /* getenv, setenv, strtoul */
+#include <stdio.h>      /* sprintf */
+#include <string.h>     /* strlen, strncpy, strcspn, memset */
+#include <assert.h>     /* assert */
+#include <ctype.h>      /* isdigit */
+#include <errno.h>      /* errno, ERANGE */
+
+#include "inner_watchdog.h"
+#include "wd_ctl.h"
+#include "logger.h"
+
+#define CTL_BACKLOG (4)
+#define CTL_REQUEST_WAIT_MS (50)
+#define CTL_REPLY_WAIT_SEC (5)
+#define CONFIG_FORMAT ("%lu:%lu:%lu:%d")
+
+/**********************Static Functions Implementation*************************/
+
+static int FillAddress(struct sockaddr_un* address, const char* path)
+{
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+
+    if(strlen(path) >= sizeof(address->sun_path))
+    {
+        return -1;
+    }
+
+    strncpy(address->sun_path, path, sizeof(address->sun_path) - 1);
+
+    return 0;
+}
+
+static void FormatConfig(char* buffer, const wd_config_t* config)
+{
+    sprintf(buffer, CONFIG_FORMAT, config->threshold, config->interval,
+                                    config->grace_rounds, config->log_level);
+}
+
+/* reads the digits at @text up to @end and moves @text past @end */
+static int ParseNumber(const char** text, size_t* value, char end)
+{
+    char* stop = NULL;
+    unsigned long parsed = 0;
+
+    if(!isdigit((unsigned char)**text))
+    {
+        return -1;
+    }
+
+    errno = 0;
+    parsed = strtoul(*text, &stop, 10);
+
+    if(ERANGE == errno || end != *stop)
+    {
+        return -1;
+    }
+
+    *value = parsed;
+    *text = '\0' == end ? stop : stop + 1;
+
+    return 0;
+}
+
+/* all or nothing, a malformed or out of bounds config is ignored */
+static int ParseConfig(const char* buffer, wd_config_t* config)
+{
+    wd_config_t parsed;
+    size_t log_level = 0;
+
+    if(-1 == ParseNumber(&buffer, &parsed.threshold, ':') ||
+        -1 == ParseNumber(&buffer, &parsed.interval, ':') ||
+        -1 == ParseNumber(&buffer, &parsed.grace_rounds, ':') ||
+        -1 == ParseNumber(&buffer, &log_level, '\0') ||
+                                                    LOG_VERBOSE < log_level)
+    {
+        return -1;
+    }
+
+    parsed.log_level = (int)log_level;
+
+    if(-1 == CtlCheckConfig(&parsed))
+    {
+        return -1;
+    }
+
+    *config = parsed;
+
+    return 0;
+}
+
+/*****************************API Functions************************************/
+
+int CtlParseValue(const char* text, size_t* value)
+{
+    assert(text);
+    assert(value);
+
+    return ParseNumber(&text, value, '\0');
+}
+
+int CtlCheckConfig(const wd_config_t* config)
+{
+    assert(config);
+
+    return !config->threshold || CTL_MAX_THRESHOLD < config->threshold ||
+            !config->interval || CTL_MAX_INTERVAL < config->interval ||
+            CTL_MAX_GRACE < config->grace_rounds || 0 > config->log_level ||
+                                    LOG_VERBOSE < config->log_level ? -1 : 0;
+}
+
+int CtlListen(const char* path)
+{
+    struct sockaddr_un address;
+    int listener = -1;
+
+    assert(path);
+
+    if(-1 == FillAddress(&address, path))
+    {
+        return -1;
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(-1 == listener)
+    {
+        return -1;
+    }
+
+    /* the revived client must not inherit it, the new server binds anew */
+    fcntl(listener, F_SETFD, FD_CLOEXEC);
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    unlink(path);
+
+    if(-1 == bind(listener, (struct sockaddr*)&address, sizeof(address)) ||
+                                        -1 == listen(listener, CTL_BACKLOG))
+    {
+        close(listener);
+        return -1;
+    }
+
+    return listener;
+}
+
+int CtlAccept(int listener, char* request, size_t size)
+{
+    struct pollfd input;
+    ssize_t received = 0;
+    size_t length = 0;
+    int conn = accept(listener, NULL, NULL);
+
+    assert(request);
+    assert(size);
+
+    if(-1 == conn)
+    {
+        return -1;
+    }
+
+    fcntl(conn, F_SETFD, FD_CLOEXEC);
+    input.fd = conn;
+    input.events = POLLIN;
+    request[0] = '\0';
+
+    /* the scheduler thread serves it, a silent peer mustn't hold it */
+    while(length + 1 < size && !strchr(request, '\n') &&
+                            0 < poll(&input, 1, CTL_REQUEST_WAIT_MS) &&
+            0 < (received = read(conn, request + length, size - 1 - length)))
+    {
+        length += received;
+        request[length] = '\0';
+    }
+
+    request[strcspn(request, "\r\n")] = '\0';
+
+    return conn;
+}
+
+void CtlReply(int conn, const char* reply)
+{
+    size_t length = strlen(reply);
+    ssize_t sent = 0;
+
+    while(length && 0 < (sent = send(conn, reply, length, MSG_NOSIGNAL)))
+    {
+        reply += sent;
+        length -= sent;
+    }
+
+    close(conn);
+}
+
+void CtlClose(int listener, const char* path)
+{
+    if(-1 != listener)
+    {
+        close(listener);
+        unlink(path);
+    }
+}
+
+int CtlRequest(const char* path, const char* request, char* reply,
+                                                                size_t size)
+{
+    struct sockaddr_un address;
+    struct timeval wait;
+    ssize_t received = 0;
+    size_t length = 0;
+    int sock = -1;
+
+    assert(path);
+    assert(request);
+    assert(reply);
+    assert(size);
+
+    if(-1 == FillAddress(&address, path))
+    {
+        return -1;
+    }
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(-1 == sock)
+    {
+        return -1;
+    }
+
+    /* the server polls its socket once every CTL_POLL_SEC */
+    wait.tv_sec = CTL_REPLY_WAIT_SEC;
+    wait.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+
+    if(-1 == connect(sock, (struct sockaddr*)&address, sizeof(address)) ||
+        -1 == send(sock, request, strlen(request), MSG_NOSIGNAL) ||
+        -1 == send(sock, "\n", 1, MSG_NOSIGNAL))
+    {
+        close(sock);
+        return -1;
+    }
+
+    while(length + 1 < size &&
+                0 < (received = recv(sock, reply + length, size - 1 - length, 0)))
+    {
+        length += received;
+    }
+
+    reply[length] = '\0';
+    close(sock);
+
+    return -1 == received || 0 == length ? -1 : 0;
+}
+
+int CtlSendConfig(int sock, const wd_config_t* config)
+{
+    char buffer[BUFSIZE * 2];
+
+    assert(config);
+
+    FormatConfig(buffer, config);
+
+    return -1 == send(sock, buffer, strlen(buffer),
+                                        MSG_DONTWAIT | MSG_NOSIGNAL) ? -1 : 0;
+}
+
+int CtlReceiveConfig(int sock, wd_config_t* config)
+{
+    char buffer[BUFSIZE * 2];
+    ssize_t received = 0;
+    int status = -1;
+
+    assert(config);
+
+    while(-1 != sock &&
+        0 < (received = recv(sock, buffer, sizeof(buffer) - 1, MSG_DONTWAIT)))
+    {
+        buffer[received] = '\0';
+
+        if(0 == ParseConfig(buffer, config))
+        {
+            status = 0;
+        }
+    }
+
+    return status;
+}
+
+void CtlExportConfig(const wd_config_t* config)
+{
+    char buffer[BUFSIZE * 2];
+
+    assert(config);
+
+    FormatConfig(buffer, config);
+    setenv(CONFIG_ENV_NAME, buffer, 1);
+}
+
+int CtlImportConfig(wd_config_t* config)
+{
+    char* buffer = getenv(CONFIG_ENV_NAME);
+
+    assert(config);
+
+    return buffer ? ParseConfig(buffer, config) : -1;
+}
\ No newline at end of file
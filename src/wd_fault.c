@@ -0,0 +1,96 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>     /* getenv, rand_r */
+#include <stdio.h>      /* sscanf */
+#include <unistd.h>     /* getpid */
+#include <time.h>       /* nanosleep, clock_gettime */
+
+#include "wd_fault.h"
+
+typedef struct wd_fault
+{
+    int armed;
+    unsigned int drop_percent;
+    unsigned int delay_ms;
+    unsigned int log_delay_ms;
+    struct timespec start;
+    unsigned int seed;
+} wd_fault_t;
+
+static wd_fault_t fault;
+
+/**********************Static Functions Implementation*************************/
+
+static void SleepMsec(unsigned int msec)
+{
+    struct timespec delay;
+
+    delay.tv_sec = msec / 1000;
+    delay.tv_nsec = (long)(msec % 1000) * 1000000;
+
+    while(-1 == nanosleep(&delay, &delay))
+    {
+    }
+}
+
+/* read only, so the logger may ask from a signal handler */
+static int IsActive(void)
+{
+    struct timespec now;
+
+    if(!fault.armed)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec > fault.start.tv_sec || (now.tv_sec ==
+                fault.start.tv_sec && now.tv_nsec >= fault.start.tv_nsec);
+}
+
+/*****************************API Functions************************************/
+
+void FaultLoad(int location)
+{
+    const char* value = getenv(FAULT_ENV_NAME);
+    int side = FAULT_BOTH;
+    unsigned int after_ms = 0;
+
+    fault.armed = value && 5 == sscanf(value, FAULT_FORMAT, &side,
+                                &fault.drop_percent, &fault.delay_ms,
+                                &fault.log_delay_ms, &after_ms) &&
+                                (FAULT_BOTH == side || location == side);
+    fault.seed = (unsigned int)getpid();
+
+    clock_gettime(CLOCK_MONOTONIC, &fault.start);
+    fault.start.tv_sec += after_ms / 1000;
+    fault.start.tv_nsec += (long)(after_ms % 1000) * 1000000;
+    if(fault.start.tv_nsec >= 1000000000L)
+    {
+        ++fault.start.tv_sec;
+        fault.start.tv_nsec -= 1000000000L;
+    }
+}
+
+int FaultDropBeat(void)
+{
+    return IsActive() && (unsigned int)(rand_r(&fault.seed) % 100) <
+                                                            fault.drop_percent;
+}
+
+void FaultDelayBeat(void)
+{
+    if(IsActive() && fault.delay_ms)
+    {
+        SleepMsec(fault.delay_ms);
+    }
+}
+
+void FaultSlowLog(void)
+{
+    if(IsActive() && fault.log_delay_ms)
+    {
+        SleepMsec(fault.log_delay_ms);
+    }
+}
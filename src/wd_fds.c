@@ -0,0 +1,239 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <sys/socket.h> /* sendmsg, recvmsg, CMSG_* */
+#include <unistd.h>     /* close */
+#include <fcntl.h>      /* fcntl, FD_CLOEXEC */
+#include <stdlib.h>     /* getenv, setenv, strtol */
+#include <stdio.h>      /* sprintf */
+#include <string.h>     /* memcpy, strlen */
+#include <assert.h>     /* assert */
+
+#include "watchdog.h"
+#include "inner_watchdog.h"
+#include "wd_fds.h"
+
+typedef struct fd_table
+{
+    int fds[WD_MAX_LISTEN_FDS];
+    size_t count;
+    int sock;
+} fd_table_t;
+
+/* client: fds shared so far, server: fds held for the next revival */
+static fd_table_t table = {{0}, 0, -1};
+
+/**********************Static Functions Implementation*************************/
+
+static int SendFd(int sock, int fd)
+{
+    struct msghdr message = {0};
+    struct iovec payload;
+    struct cmsghdr* control = NULL;
+    char control_buffer[CMSG_SPACE(sizeof(int))];
+    char tag = 'F';
+
+    payload.iov_base = &tag;
+    payload.iov_len = sizeof(tag);
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control_buffer;
+    message.msg_controllen = sizeof(control_buffer);
+
+    control = CMSG_FIRSTHDR(&message);
+    control->cmsg_level = SOL_SOCKET;
+    control->cmsg_type = SCM_RIGHTS;
+    control->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(control), &fd, sizeof(int));
+
+    return -1 == sendmsg(sock, &message, MSG_DONTWAIT) ? -1 : 0;
+}
+
+static int ReceiveFd(int sock)
+{
+    struct msghdr message = {0};
+    struct iovec payload;
+    struct cmsghdr* control = NULL;
+    char control_buffer[CMSG_SPACE(sizeof(int))];
+    char tag = 0;
+    int fd = -1;
+
+    payload.iov_base = &tag;
+    payload.iov_len = sizeof(tag);
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control_buffer;
+    message.msg_controllen = sizeof(control_buffer);
+
+    if(0 >= recvmsg(sock, &message, MSG_DONTWAIT))
+    {
+        return -1;
+    }
+
+    control = CMSG_FIRSTHDR(&message);
+
+    if(!control || SCM_RIGHTS != control->cmsg_type)
+    {
+        return -1;
+    }
+
+    memcpy(&fd, CMSG_DATA(control), sizeof(int));
+
+    return fd;
+}
+
+static int IsShared(int fd)
+{
+    size_t i = 0;
+
+    for(; i < table.count; ++i)
+    {
+        if(table.fds[i] == fd)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* a revived client adopts the fds the watchdog process passed on */
+static void AdoptInherited(void)
+{
+    char* runner = getenv(LISTEN_ENV_NAME);
+    int fd = 0;
+
+    while(runner && *runner && table.count < WD_MAX_LISTEN_FDS)
+    {
+        fd = (int)strtol(runner, &runner, 10);
+        runner += (',' == *runner);
+
+        if(!IsShared(fd))
+        {
+            table.fds[table.count++] = fd;
+        }
+    }
+}
+
+/*****************************API Functions************************************/
+
+wd_status_t WDShareListenFd(int fd)
+{
+    if(IsShared(fd))
+    {
+        return WD_SUCCESS;
+    }
+
+    if(WD_MAX_LISTEN_FDS == table.count)
+    {
+        return WD_FAILED;
+    }
+
+    table.fds[table.count++] = fd;
+
+    /* not connected yet, @FdsConnect sends it */
+    if(-1 != table.sock && -1 == SendFd(table.sock, fd))
+    {
+        return WD_FAILED;
+    }
+
+    return WD_SUCCESS;
+}
+
+size_t WDGetListenFds(int* fds, size_t max)
+{
+    char* runner = getenv(LISTEN_ENV_NAME);
+    size_t count = 0;
+
+    assert(fds || 0 == max);
+
+    while(runner && *runner && count < max)
+    {
+        fds[count++] = (int)strtol(runner, &runner, 10);
+        runner += (',' == *runner);
+    }
+
+    return count;
+}
+
+void FdsConnect(int sock)
+{
+    size_t i = 0;
+
+    if(-1 != table.sock)
+    {
+        close(table.sock);
+    }
+
+    table.sock = sock;
+    AdoptInherited();
+
+    for(; i < table.count; ++i)
+    {
+        SendFd(table.sock, table.fds[i]);
+    }
+}
+
+void FdsServe(int sock)
+{
+    /* the revived client must not inherit the old pair */
+    fcntl(sock, F_SETFD, FD_CLOEXEC);
+    table.sock = sock;
+    table.count = 0;
+}
+
+int FdsReceive(void)
+{
+    int fd = -1;
+
+    while(-1 != table.sock && -1 != (fd = ReceiveFd(table.sock)))
+    {
+        if(WD_MAX_LISTEN_FDS == table.count)
+        {
+            close(fd);
+            continue;
+        }
+
+        table.fds[table.count++] = fd;
+    }
+
+    return table.count;
+}
+
+int FdsSocket(void)
+{
+    return table.sock;
+}
+
+void FdsKeepOnExec(void)
+{
+    size_t i = 0;
+
+    AdoptInherited();
+
+    for(; i < table.count; ++i)
+    {
+        fcntl(table.fds[i], F_SETFD,
+                            fcntl(table.fds[i], F_GETFD) & ~FD_CLOEXEC);
+    }
+}
+
+void FdsExport(void)
+{
+    char buffer[WD_MAX_LISTEN_FDS * (BUFSIZE / 4)];
+    size_t i = 0;
+
+    buffer[0] = '\0';
+
+    for(; i < table.count; ++i)
+    {
+        sprintf(buffer + strlen(buffer), i ? ",%d" : "%d", table.fds[i]);
+    }
+
+    if(0 == table.count)
+    {
+        unsetenv(LISTEN_ENV_NAME);
+        return;
+    }
+
+    setenv(LISTEN_ENV_NAME, buffer, 1);
+}
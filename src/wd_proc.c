@@ -0,0 +1,364 @@
+#define _GNU_SOURCE
+
+#include <unistd.h>         /* pread, close, lseek, syscall */
+#include <fcntl.h>          /* open, openat, O_RDONLY */
+#include <stdio.h>          /* sprintf */
+#include <stdlib.h>         /* strtoul */
+#include <string.h>         /* strrchr */
+#include <sys/syscall.h>    /* SYS_getdents64 */
+#include <time.h>           /* clock_gettime */
+
+#include "wd_proc.h"
+
+#define STAT_BUFSIZE (1024)
+#define DIRENT_BUFSIZE (4096)
+#define PATH_BUFSIZE (64)
+#define FIELDS_TO_UTIME (11)
+#define STARVED_SHARE (2)
+
+typedef struct linux_dirent64 {
+    unsigned long d_ino;
+    long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+} linux_dirent64_t;
+
+static const char* hang_names[] = {
+    "unknown", "dead", "stopped", "io wait", "starved", "spinning", "deadlock"
+};
+
+/**********************Static Functions Implementation*************************/
+
+static unsigned long NowTicks(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * sysconf(_SC_CLK_TCK) +
+                        now.tv_nsec / (1000000000 / sysconf(_SC_CLK_TCK));
+}
+
+static int ReadStat(int fd, char* state, unsigned long* cpu_ticks)
+{
+    char buffer[STAT_BUFSIZE];
+    char* runner = NULL;
+    ssize_t bytes = 0;
+    int i = 0;
+
+    bytes = pread(fd, buffer, sizeof(buffer) - 1, 0);
+
+    if(bytes <= 0)
+    {
+        return -1;
+    }
+
+    buffer[bytes] = '\0';
+
+    /* comm may hold spaces and parentheses, the last ')' closes it */
+    runner = strrchr(buffer, ')');
+
+    if(!runner || runner[1] == '\0')
+    {
+        return -1;
+    }
+
+    *state = runner[2];
+
+    for(runner += 2; i < FIELDS_TO_UTIME && runner; ++i)
+    {
+        runner = strchr(runner + 1, ' ');
+    }
+
+    if(!runner)
+    {
+        return -1;
+    }
+
+    *cpu_ticks = strtoul(runner, &runner, 10);
+    *cpu_ticks += strtoul(runner, NULL, 10);
+
+    return 0;
+}
+
+static size_t CountEntries(int dir_fd)
+{
+    char buffer[DIRENT_BUFSIZE];
+    linux_dirent64_t* entry = NULL;
+    long bytes = 0;
+    long offset = 0;
+    size_t count = 0;
+
+    if(-1 == lseek(dir_fd, 0, SEEK_SET))
+    {
+        return 0;
+    }
+
+    while(0 < (bytes = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer))))
+    {
+        for(offset = 0; offset < bytes; offset += entry->d_reclen)
+        {
+            entry = (linux_dirent64_t*)(buffer + offset);
+            count += ('.' != entry->d_name[0]);
+        }
+    }
+
+    return count;
+}
+
+static int HasTask(const wd_proc_t* proc, pid_t tid)
+{
+    size_t i = 0;
+
+    for(; i < proc->task_count; ++i)
+    {
+        if(proc->tasks[i].tid == tid)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void RefreshTasks(wd_proc_t* proc)
+{
+    char buffer[DIRENT_BUFSIZE];
+    char path[PATH_BUFSIZE];
+    linux_dirent64_t* entry = NULL;
+    long bytes = 0;
+    long offset = 0;
+    pid_t tid = 0;
+    int fd = -1;
+
+    if(-1 == proc->task_dir_fd || -1 == lseek(proc->task_dir_fd, 0, SEEK_SET))
+    {
+        return;
+    }
+
+    while(0 < (bytes = syscall(SYS_getdents64, proc->task_dir_fd, buffer,
+                                                            sizeof(buffer))))
+    {
+        for(offset = 0; offset < bytes; offset += entry->d_reclen)
+        {
+            entry = (linux_dirent64_t*)(buffer + offset);
+            tid = (pid_t)strtoul(entry->d_name, NULL, 10);
+
+            if(0 == tid || HasTask(proc, tid) ||
+                                        PROC_MAX_TASKS == proc->task_count)
+            {
+                continue;
+            }
+
+            sprintf(path, "%d/stat", tid);
+            fd = openat(proc->task_dir_fd, path, O_RDONLY | O_CLOEXEC);
+
+            if(-1 != fd)
+            {
+                proc->tasks[proc->task_count].tid = tid;
+                proc->tasks[proc->task_count].stat_fd = fd;
+                ++proc->task_count;
+            }
+        }
+    }
+}
+
+/*****************************API Functions************************************/
+
+int ProcOpen(wd_proc_t* proc, pid_t pid)
+{
+    char path[PATH_BUFSIZE];
+
+    proc->pid = pid;
+    proc->task_count = 0;
+    proc->cpu_ticks = 0;
+
+    sprintf(path, "/proc/%d/stat", pid);
+    proc->stat_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    sprintf(path, "/proc/%d/task", pid);
+    proc->task_dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    sprintf(path, "/proc/%d/statm", pid);
+    proc->statm_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    sprintf(path, "/proc/%d/fd", pid);
+    proc->fd_dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if(-1 == proc->stat_fd || -1 == proc->task_dir_fd ||
+                            -1 == proc->statm_fd || -1 == proc->fd_dir_fd)
+    {
+        ProcClose(proc);
+        return -1;
+    }
+
+    RefreshTasks(proc);
+    ProcMark(proc);
+
+    return 0;
+}
+
+void ProcClose(wd_proc_t* proc)
+{
+    size_t i = 0;
+
+    for(; i < proc->task_count; ++i)
+    {
+        close(proc->tasks[i].stat_fd);
+    }
+
+    if(-1 != proc->stat_fd)
+    {
+        close(proc->stat_fd);
+    }
+
+    if(-1 != proc->task_dir_fd)
+    {
+        close(proc->task_dir_fd);
+    }
+
+    if(-1 != proc->statm_fd)
+    {
+        close(proc->statm_fd);
+    }
+
+    if(-1 != proc->fd_dir_fd)
+    {
+        close(proc->fd_dir_fd);
+    }
+
+    proc->task_count = 0;
+    proc->stat_fd = -1;
+    proc->task_dir_fd = -1;
+    proc->statm_fd = -1;
+    proc->fd_dir_fd = -1;
+}
+
+int ProcSample(wd_proc_t* proc, proc_sample_t* sample)
+{
+    unsigned long ticks = 0;
+    char state = 0;
+    size_t i = 0;
+
+    sample->threads = 0;
+    sample->running = 0;
+    sample->io_wait = 0;
+    sample->stopped = 0;
+
+    if(-1 == proc->stat_fd || -1 == ReadStat(proc->stat_fd, &sample->state,
+                                                        &sample->cpu_ticks))
+    {
+        return -1;
+    }
+
+    RefreshTasks(proc);
+
+    while(i < proc->task_count)
+    {
+        /* an exited thread fails the read, its slot is recycled */
+        if(-1 == ReadStat(proc->tasks[i].stat_fd, &state, &ticks))
+        {
+            close(proc->tasks[i].stat_fd);
+            proc->tasks[i] = proc->tasks[--proc->task_count];
+            continue;
+        }
+
+        ++sample->threads;
+        sample->running += ('R' == state);
+        sample->io_wait += ('D' == state);
+        sample->stopped += ('T' == state || 't' == state);
+        ++i;
+    }
+
+    return 0;
+}
+
+int ProcResources(wd_proc_t* proc, proc_resources_t* resources)
+{
+    char buffer[STAT_BUFSIZE];
+    char* runner = NULL;
+    char state = 0;
+    ssize_t bytes = 0;
+
+    if(-1 == proc->statm_fd ||
+                -1 == ReadStat(proc->stat_fd, &state, &resources->cpu_ticks))
+    {
+        return -1;
+    }
+
+    bytes = pread(proc->statm_fd, buffer, sizeof(buffer) - 1, 0);
+
+    if(bytes <= 0)
+    {
+        return -1;
+    }
+
+    buffer[bytes] = '\0';
+
+    /* statm is "size resident shared ..." counted in pages */
+    strtoul(buffer, &runner, 10);
+    resources->rss_kb = strtoul(runner, NULL, 10) * (sysconf(_SC_PAGESIZE) /
+                                                                        1024);
+    resources->fds = CountEntries(proc->fd_dir_fd);
+    resources->now_ticks = NowTicks();
+
+    return 0;
+}
+
+void ProcMark(wd_proc_t* proc)
+{
+    char state = 0;
+
+    if(-1 != proc->stat_fd)
+    {
+        ReadStat(proc->stat_fd, &state, &proc->cpu_ticks);
+        proc->mark_ticks = NowTicks();
+    }
+}
+
+wd_hang_t ProcClassify(wd_proc_t* proc)
+{
+    proc_sample_t sample;
+    unsigned long used_ticks = 0;
+    unsigned long elapsed_ticks = 0;
+
+    if(-1 == proc->stat_fd)
+    {
+        return HANG_UNKNOWN;
+    }
+
+    if(-1 == ProcSample(proc, &sample) ||
+                                'Z' == sample.state || 'X' == sample.state)
+    {
+        return HANG_DEAD;
+    }
+
+    if('T' == sample.state || 't' == sample.state || sample.stopped)
+    {
+        return HANG_STOPPED;
+    }
+
+    if(sample.io_wait)
+    {
+        return HANG_IO_WAIT;
+    }
+
+    used_ticks = sample.cpu_ticks - proc->cpu_ticks;
+    elapsed_ticks = NowTicks() - proc->mark_ticks;
+    ProcMark(proc);
+
+    if(!sample.running)
+    {
+        return HANG_DEADLOCK;
+    }
+
+    /* runnable yet barely got the cpu means someone else is hogging it */
+    return used_ticks * STARVED_SHARE < elapsed_ticks ? HANG_STARVED :
+                                                            HANG_SPINNING;
+}
+
+const char* ProcHangName(wd_hang_t hang)
+{
+    return hang_names[hang];
+}
@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>     /* getenv, malloc, calloc, realloc, free */
+#include <stdio.h>      /* sscanf */
+#include <string.h>     /* strlen */
+#include <unistd.h>     /* sysconf, write */
+#include <pthread.h>    /* pthread_setschedparam, pthread_setaffinity_np */
+#include <sched.h>      /* SCHED_FIFO, cpu_set_t, CPU_SET */
+#include <sys/mman.h>   /* mlockall, MCL_CURRENT, MCL_FUTURE */
+#include <assert.h>     /* assert */
+
+#include "inner_watchdog.h"
+#include "wd_rt.h"
+
+#define STACK_PREFAULT (64 * 1024)
+#define PAGE_GUESS (4096)
+
+/**********************Static Functions Implementation*************************/
+
+/* touches the stack the thread may grow into, so it faults in now */
+static void PrefaultStack(void)
+{
+    volatile char stack[STACK_PREFAULT];
+    size_t i = 0;
+
+    for(; i < sizeof(stack); i += PAGE_GUESS)
+    {
+        stack[i] = 0;
+    }
+}
+
+static int SetPriority(int priority)
+{
+    struct sched_param param = {0};
+
+    param.sched_priority = priority;
+
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+static int SetAffinity(int cpu)
+{
+    cpu_set_t set;
+
+    if(cpu >= sysconf(_SC_NPROCESSORS_CONF))
+    {
+        return -1;
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+#ifdef WD_RT_MALLOC_CHECK
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static __thread int armed;
+
+/* the assert machinery allocates itself, so disarm and report by hand */
+static void Violation(const char* call)
+{
+    static const char message[] = "watchdog: allocation in real-time mode: ";
+
+    armed = 0;
+    write(STDERR_FILENO, message, sizeof(message) - 1);
+    write(STDERR_FILENO, call, strlen(call));
+    write(STDERR_FILENO, "\n", 1);
+    abort();
+}
+
+void* malloc(size_t size)
+{
+    if(armed)
+    {
+        Violation("malloc");
+    }
+
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if(armed)
+    {
+        Violation("calloc");
+    }
+
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if(armed)
+    {
+        Violation("realloc");
+    }
+
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    if(armed && ptr)
+    {
+        Violation("free");
+    }
+
+    __libc_free(ptr);
+}
+
+void RtArm(void)
+{
+    armed = 1;
+}
+
+void RtDisarm(void)
+{
+    armed = 0;
+}
+
+#else
+
+void RtArm(void)
+{
+}
+
+void RtDisarm(void)
+{
+}
+
+#endif /* WD_RT_MALLOC_CHECK */
+
+/*****************************API Functions************************************/
+
+int RtLoad(wd_rt_t* rt)
+{
+    const char* value = getenv(RT_ENV_NAME);
+
+    assert(rt);
+
+    return value && 2 == sscanf(value, "%d:%d", &rt->cpu, &rt->priority);
+}
+
+int RtEnter(const wd_rt_t* rt, int lock_future)
+{
+    int failed = 0;
+
+    assert(rt);
+
+    if(-1 == mlockall(MCL_CURRENT | (lock_future ? MCL_FUTURE : 0)))
+    {
+        failed |= RT_FAILED_LOCK;
+    }
+
+    PrefaultStack();
+
+    if(rt->priority > 0 && SetPriority(rt->priority))
+    {
+        failed |= RT_FAILED_PRIORITY;
+    }
+
+    if(rt->cpu >= 0 && SetAffinity(rt->cpu))
+    {
+        failed |= RT_FAILED_AFFINITY;
+    }
+
+    return failed;
+}
@@ -0,0 +1,144 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <sys/mman.h>   /* shm_open, shm_unlink, mmap, munmap */
+#include <sys/stat.h>   /* fstat */
+#include <fcntl.h>      /* O_CREAT, O_RDWR */
+#include <unistd.h>     /* ftruncate, close */
+#include <string.h>     /* strlen, strcpy, strcat, memset */
+#include <stdatomic.h>  /* atomic_int */
+#include <assert.h>     /* assert */
+
+#include "watchdog.h"
+#include "wd_state.h"
+
+typedef struct state_header
+{
+    unsigned long magic;
+    unsigned long size;
+    unsigned int version;
+    atomic_int valid;
+} state_header_t;
+
+typedef struct state_region
+{
+    char name[WD_STATE_NAME_MAX + sizeof(STATE_NAME_PREFIX)];
+    state_header_t* header;
+    size_t total_size;
+} state_region_t;
+
+static state_region_t regions[WD_MAX_STATE_REGIONS];
+
+/**********************Static Functions Implementation*************************/
+
+static state_region_t* FreeRegion(void)
+{
+    size_t i = 0;
+
+    for(; i < WD_MAX_STATE_REGIONS; ++i)
+    {
+        if(!regions[i].header)
+        {
+            return regions + i;
+        }
+    }
+
+    return NULL;
+}
+
+static int IsWarm(const state_header_t* header, size_t size,
+                                                        unsigned int version)
+{
+    return STATE_MAGIC == header->magic && size == header->size &&
+                    version == header->version && atomic_load(&header->valid);
+}
+
+/*****************************API Functions************************************/
+
+void* WDStateAttach(const char* name, size_t size, unsigned int version,
+                                                                int* is_warm)
+{
+    state_region_t* region = FreeRegion();
+    struct stat status;
+    void* mapping = NULL;
+    int fd = -1;
+
+    assert(name);
+    assert(is_warm);
+    assert(strlen(name) <= WD_STATE_NAME_MAX);
+
+    if(!region)
+    {
+        return NULL;
+    }
+
+    strcpy(region->name, STATE_NAME_PREFIX);
+    strcat(region->name, name);
+    region->total_size = STATE_HEADER_SIZE + size;
+
+    fd = shm_open(region->name, O_CREAT | O_RDWR, 0600);
+
+    if(-1 == fd)
+    {
+        return NULL;
+    }
+
+    if(-1 == fstat(fd, &status) || ((size_t)status.st_size !=
+            region->total_size && -1 == ftruncate(fd, region->total_size)))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    mapping = mmap(NULL, region->total_size, PROT_READ | PROT_WRITE,
+                                                        MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(MAP_FAILED == mapping)
+    {
+        return NULL;
+    }
+
+    region->header = (state_header_t*)mapping;
+    *is_warm = IsWarm(region->header, size, version);
+
+    if(!*is_warm)
+    {
+        memset(mapping, 0, region->total_size);
+        region->header->magic = STATE_MAGIC;
+        region->header->size = size;
+        region->header->version = version;
+    }
+
+    return (char*)mapping + STATE_HEADER_SIZE;
+}
+
+void WDStateCommit(void* state)
+{
+    state_header_t* header = (state_header_t*)((char*)state -
+                                                            STATE_HEADER_SIZE);
+
+    atomic_store(&header->valid, 1);
+}
+
+void WDStateInvalidate(void* state)
+{
+    state_header_t* header = (state_header_t*)((char*)state -
+                                                            STATE_HEADER_SIZE);
+
+    atomic_store(&header->valid, 0);
+}
+
+void StateDiscardAll(void)
+{
+    size_t i = 0;
+
+    for(; i < WD_MAX_STATE_REGIONS; ++i)
+    {
+        if(regions[i].header)
+        {
+            munmap(regions[i].header, regions[i].total_size);
+            shm_unlink(regions[i].name);
+            regions[i].header = NULL;
+        }
+    }
+}
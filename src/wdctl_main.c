@@ -0,0 +1,47 @@
+#include <stdio.h>      /* printf, fputs, fprintf */
+#include <string.h>     /* strlen, strcat, strncmp */
+
+#include "wd_ctl.h"
+
+static void Usage(const char* name)
+{
+    printf("usage: %s status\n", name);
+    printf("       %s set threshold|interval|grace <n>\n", name);
+    printf("       %s set rss|fds|cpu|samples <n>\n", name);
+    printf("       %s set log <0 quiet, 1 events, 2 verbose>\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    char request[CTL_MAX_REQUEST] = {0};
+    char reply[CTL_MAX_REPLY];
+    int i = 1;
+
+    if(argc < 2)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    for(; i < argc; ++i)
+    {
+        if(strlen(request) + strlen(argv[i]) + 2 > sizeof(request))
+        {
+            fprintf(stderr, "%s: request too long\n", argv[0]);
+            return 2;
+        }
+
+        strcat(request, 1 == i ? "" : " ");
+        strcat(request, argv[i]);
+    }
+
+    if(-1 == CtlRequest(CTL_PATH, request, reply, sizeof(reply)))
+    {
+        fprintf(stderr, "%s: no watchdog answered at %s\n", argv[0], CTL_PATH);
+        return 1;
+    }
+
+    fputs(reply, stdout);
+
+    return 0 == strncmp(reply, "error", 5);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <stdlib.h>     /* atoi */
+#include <unistd.h>     /* sysconf */
+#include <time.h>       /* nanosleep */
+
+#include "sched_group.h"
+
+#define TASKS (1024)
+#define WORK (2000)
+#define RUN_SEC (2)
+#define MAX_SHARDS (64)
+
+/* a probe of a few microseconds, due again right away */
+static int Probe(void* params)
+{
+    volatile size_t sum = 0;
+    size_t i = 0;
+
+    for(; i < WORK; ++i)
+    {
+        sum += i;
+    }
+
+    (void)params;
+
+    return 0;
+}
+
+/* @skewed pins every task to the same shard, so only stealing spreads them */
+static void Bench(size_t shards, int skewed)
+{
+    sched_shard_stats_t stats[MAX_SHARDS];
+    struct timespec run = {RUN_SEC, 0};
+    sched_group_t* group = SchedGroupCreate(shards);
+    size_t runs = 0;
+    size_t steals = 0;
+    size_t count = 0;
+    size_t i = 0;
+
+    if(!group)
+    {
+        printf("SchedGroupCreate failed\n");
+        return;
+    }
+
+    for(i = 0; i < TASKS; ++i)
+    {
+        SchedGroupAdd(group, Probe, NULL, 0, skewed ? 0 : i);
+    }
+
+    SchedGroupStart(group);
+    nanosleep(&run, NULL);
+    SchedGroupStop(group);
+
+    count = SchedGroupStats(group, stats, MAX_SHARDS);
+    for(i = 0; i < count; ++i)
+    {
+        runs += stats[i].runs;
+        steals += stats[i].steals;
+    }
+
+    printf("%-8s %6lu shards %12.0f runs/s %10lu steals\n",
+            skewed ? "skewed" : "uniform", shards,
+            (double)runs / RUN_SEC, steals);
+
+    SchedGroupDestroy(group);
+}
+
+int main(int argc, char* argv[])
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max = argc > 1 ? (size_t)atoi(argv[1]) : (size_t)cores;
+    size_t shards = 1;
+
+    max = max < MAX_SHARDS ? max : MAX_SHARDS;
+    printf("%ld cores, %d tasks\n", cores, TASKS);
+
+    for(; shards <= max; shards *= 2)
+    {
+        Bench(shards, 0);
+        Bench(shards, 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <stdlib.h>     /* malloc, free, atoi */
+#include <pthread.h>    /* pthread_create, pthread_join, pthread_mutex_t */
+#include <time.h>       /* clock_gettime */
+
+#include "heap_pq.h"
+#include "multi_pq.h"
+
+#define ITEMS (4096)
+#define OPS (200000)
+#define MAX_THREADS (32)
+#define MAX_INTERVAL (60)
+#define QUEUES_PER_THREAD (2)
+
+typedef struct item
+{
+    unsigned long key;
+    size_t interval;
+} item_t;
+
+/* one shared queue behind one lock, or the multi queue */
+typedef struct bench
+{
+    heap_pq_t* pq;
+    pthread_mutex_t lock;
+    multi_pq_t* mpq;
+} bench_t;
+
+static int CompareItems(const void* one, const void* other)
+{
+    unsigned long one_key = ((const item_t*)one)->key;
+    unsigned long other_key = ((const item_t*)other)->key;
+
+    return (one_key > other_key) - (one_key < other_key);
+}
+
+static unsigned long ItemKey(const void* item)
+{
+    return ((const item_t*)item)->key;
+}
+
+static double NowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static item_t* Take(bench_t* bench)
+{
+    item_t* item = NULL;
+
+    if(bench->mpq)
+    {
+        return (item_t*)MPQDequeue(bench->mpq);
+    }
+
+    pthread_mutex_lock(&bench->lock);
+    item = PQIsEmpty(bench->pq) ? NULL : (item_t*)PQDequeue(bench->pq);
+    pthread_mutex_unlock(&bench->lock);
+
+    return item;
+}
+
+static void Put(bench_t* bench, item_t* item)
+{
+    if(bench->mpq)
+    {
+        MPQEnqueue(bench->mpq, item);
+        return;
+    }
+
+    pthread_mutex_lock(&bench->lock);
+    PQEnqueue(bench->pq, item);
+    pthread_mutex_unlock(&bench->lock);
+}
+
+/* every op takes the next due item and puts it back one interval later */
+static void* Worker(void* params)
+{
+    bench_t* bench = (bench_t*)params;
+    item_t* item = NULL;
+    size_t i = 0;
+
+    for(; i < OPS; ++i)
+    {
+        if((item = Take(bench)))
+        {
+            item->key += item->interval;
+            Put(bench, item);
+        }
+    }
+
+    return NULL;
+}
+
+static void Run(const char* name, size_t threads, int multi)
+{
+    pthread_t workers[MAX_THREADS];
+    item_t* items = (item_t*)malloc(ITEMS * sizeof(item_t));
+    bench_t bench;
+    double start = 0;
+    size_t i = 0;
+
+    bench.pq = multi ? NULL : PQCreate(CompareItems);
+    bench.mpq = multi ? MPQCreate(threads * QUEUES_PER_THREAD, ItemKey) : NULL;
+    pthread_mutex_init(&bench.lock, NULL);
+
+    srand(1);
+    for(; i < ITEMS; ++i)
+    {
+        items[i].interval = 1 + rand() % MAX_INTERVAL;
+        items[i].key = items[i].interval;
+        Put(&bench, items + i);
+    }
+
+    start = NowSec();
+    for(i = 0; i < threads; ++i)
+    {
+        pthread_create(workers + i, NULL, Worker, &bench);
+    }
+
+    for(i = 0; i < threads; ++i)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    printf("%-16s %3lu threads %10.1f ns/op %12.0f ops/s\n", name, threads,
+            (NowSec() - start) * 1e9 / (OPS * threads),
+            OPS * threads / (NowSec() - start));
+
+    if(multi)
+    {
+        MPQDestroy(bench.mpq);
+    }
+    else
+    {
+        PQDestroy(bench.pq);
+    }
+
+    pthread_mutex_destroy(&bench.lock);
+    free(items);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t max = argc > 1 ? (size_t)atoi(argv[1]) : MAX_THREADS;
+    size_t threads = 1;
+
+    max = max < MAX_THREADS ? max : MAX_THREADS;
+    printf("%d items, %d ops per thread\n", ITEMS, OPS);
+
+    for(; threads <= max; threads *= 2)
+    {
+        Run("mutex heap_pq", threads, 0);
+        Run("multi_pq", threads, 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <stdlib.h>     /* malloc, free, rand, srand, atoi */
+#include <time.h>       /* clock_gettime */
+
+#include "heap_pq.h"
+#include "typed_ds.h"
+
+#define ELEMENTS (100000)
+#define ROUNDS (1000000)
+#define MAX_INTERVAL (60)
+
+typedef struct item
+{
+    unsigned long key;
+    size_t interval;
+} item_t;
+
+#define ITEM_LESS(a, b) ((a)->key < (b)->key)
+
+DEFINE_PQ(ItemPQ, item_t*, ITEM_LESS)
+
+static int CompareItems(const void* one, const void* other)
+{
+    unsigned long one_key = ((const item_t*)one)->key;
+    unsigned long other_key = ((const item_t*)other)->key;
+
+    return (one_key > other_key) - (one_key < other_key);
+}
+
+static unsigned long ItemKey(const void* item)
+{
+    return ((const item_t*)item)->key;
+}
+
+static double NowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void Report(const char* name, size_t ops, double start)
+{
+    printf("%-28s %10.1f ns/op\n", name, (NowSec() - start) * 1e9 / ops);
+}
+
+static void ResetItems(item_t* items, size_t count)
+{
+    size_t i = 0;
+
+    srand(1);
+
+    for(; i < count; ++i)
+    {
+        items[i].interval = 1 + rand() % MAX_INTERVAL;
+        items[i].key = items[i].interval;
+    }
+}
+
+static void FillDrain(const char* name, heap_pq_t* pq, item_t* items,
+                                                                size_t count)
+{
+    double start = 0;
+    size_t i = 0;
+
+    ResetItems(items, count);
+    start = NowSec();
+
+    for(i = 0; i < count; ++i)
+    {
+        PQEnqueue(pq, items + i);
+    }
+
+    while(!PQIsEmpty(pq))
+    {
+        PQDequeue(pq);
+    }
+
+    Report(name, count * 2, start);
+    PQDestroy(pq);
+}
+
+static void Reenqueue(const char* name, heap_pq_t* pq, item_t* items,
+                                                size_t count, size_t rounds)
+{
+    item_t* item = NULL;
+    double start = 0;
+    size_t i = 0;
+
+    ResetItems(items, count);
+
+    for(i = 0; i < count; ++i)
+    {
+        PQEnqueue(pq, items + i);
+    }
+
+    start = NowSec();
+
+    for(i = 0; i < rounds; ++i)
+    {
+        item = PQDequeue(pq);
+        item->key += item->interval;
+        PQEnqueue(pq, item);
+    }
+
+    Report(name, rounds, start);
+    PQDestroy(pq);
+}
+
+/* push all, pop all */
+static void BenchFill(item_t* items, size_t count)
+{
+    ItemPQ_t typed;
+    double start = 0;
+    size_t i = 0;
+
+    FillDrain("heap_pq fill/drain", PQCreate(CompareItems), items, count);
+    FillDrain("radix heap_pq fill/drain", PQCreateRadix(ItemKey), items, count);
+
+    ItemPQCreate(&typed, count);
+    start = NowSec();
+
+    for(i = 0; i < count; ++i)
+    {
+        ItemPQEnqueue(&typed, items + i);
+    }
+
+    while(!ItemPQIsEmpty(&typed))
+    {
+        ItemPQDequeue(&typed);
+    }
+
+    Report("ItemPQ fill/drain", count * 2, start);
+    ItemPQDestroy(&typed);
+}
+
+/* the scheduler pattern, pop the earliest task and push it back later */
+static void BenchReenqueue(item_t* items, size_t count, size_t rounds)
+{
+    ItemPQ_t typed;
+    item_t* item = NULL;
+    double start = 0;
+    size_t i = 0;
+
+    Reenqueue("heap_pq re-enqueue", PQCreate(CompareItems), items, count,
+                                                                    rounds);
+    Reenqueue("radix heap_pq re-enqueue", PQCreateRadix(ItemKey), items,
+                                                            count, rounds);
+
+    ResetItems(items, count);
+    ItemPQCreate(&typed, count);
+
+    for(i = 0; i < count; ++i)
+    {
+        ItemPQEnqueue(&typed, items + i);
+    }
+
+    start = NowSec();
+
+    for(i = 0; i < rounds; ++i)
+    {
+        item = ItemPQDequeue(&typed);
+        item->key += item->interval;
+        ItemPQEnqueue(&typed, item);
+    }
+
+    Report("ItemPQ re-enqueue", rounds, start);
+    ItemPQDestroy(&typed);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? (size_t)atoi(argv[1]) : ELEMENTS;
+    size_t rounds = argc > 2 ? (size_t)atoi(argv[2]) : ROUNDS;
+    item_t* items = (item_t*)malloc(count * sizeof(item_t));
+
+    if(!items)
+    {
+        return -1;
+    }
+
+    printf("%lu elements, %lu rounds\n", count, rounds);
+    BenchFill(items, count);
+    BenchReenqueue(items, count, rounds);
+
+    free(items);
+
+    return 0;
+}
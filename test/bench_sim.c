@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <stdlib.h>     /* malloc, free, rand, srand, atoi */
+#include <time.h>       /* clock_gettime */
+
+#include "heap_scheduler.h"
+#include "sched_clock.h"
+
+#define TASKS (100000)
+#define HOURS (1)
+#define MAX_INTERVAL (60)
+#define MAX_WORK_USEC (50)
+#define START_TIME (1000000000)
+
+typedef struct sim
+{
+    sched_clock_t* clock;
+    scheduler_t* scheduler;
+    unsigned long runs;
+    unsigned long checksum;
+} sim_t;
+
+typedef struct probe
+{
+    sim_t* sim;
+    size_t id;
+    size_t work_usec;
+} probe_t;
+
+static double NowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* models a probe that runs for @work_usec, and folds in when it ran */
+static int Probe(void* params)
+{
+    probe_t* probe = (probe_t*)params;
+    sim_t* sim = probe->sim;
+
+    ClockAdvance(sim->clock, probe->work_usec);
+    ++sim->runs;
+    sim->checksum = sim->checksum * 31 + probe->id * 7 +
+                        (unsigned long)ClockTime(sim->clock);
+
+    return 0;
+}
+
+static int End(void* params)
+{
+    SchedulerStop(((sim_t*)params)->scheduler);
+
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t tasks = argc > 1 ? (size_t)atoi(argv[1]) : TASKS;
+    size_t hours = argc > 2 ? (size_t)atoi(argv[2]) : HOURS;
+    const char* trace = argc > 3 ? argv[3] : NULL;
+    probe_t* probes = (probe_t*)malloc(tasks * sizeof(probe_t));
+    sim_t sim;
+    double start = 0;
+    size_t i = 0;
+
+    sim.clock = ClockCreateSimulated(START_TIME);
+    sim.scheduler = SchedulerCreateBackend(SCHED_RADIX_HEAP);
+    sim.runs = 0;
+    sim.checksum = 0;
+    if(!probes || !sim.clock || !sim.scheduler)
+    {
+        return 1;
+    }
+
+    SchedulerSetClock(sim.scheduler, sim.clock);
+    if (trace != NULL && SchedulerRecord(sim.scheduler, trace) != 0)
+    {
+        return 1;
+    }
+
+    srand(1);
+    for(; i < tasks; ++i)
+    {
+        probes[i].sim = &sim;
+        probes[i].id = i;
+        probes[i].work_usec = rand() % MAX_WORK_USEC;
+        SchedulerAdd(sim.scheduler, Probe, probes + i,
+                                                1 + rand() % MAX_INTERVAL);
+    }
+
+    SchedulerAddEx(sim.scheduler, End, &sim, hours * 3600, SCHED_CRITICAL,
+                                                                NULL, NULL);
+
+    start = NowSec();
+    SchedulerRun(sim.scheduler);
+
+    printf("%lu tasks, %lu simulated hours: %lu runs in %.2f s, "
+            "checksum %08lx\n", (unsigned long)tasks, (unsigned long)hours,
+            sim.runs, NowSec() - start, sim.checksum & 0xFFFFFFFFUL);
+
+    SchedulerDestroy(sim.scheduler);
+    ClockDestroy(sim.clock);
+    free(probes);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <stdlib.h>     /* atoi */
+#include <time.h>       /* clock_gettime, nanosleep */
+
+#include "watchdog.h"
+
+#define RUNS (20)
+#define THRESHOLD (3)
+#define INTERVAL (1)
+
+static double NowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void Report(const char* name, double total, size_t runs)
+{
+    printf("%-28s %10.1f us\n", name, total * 1e6 / runs);
+}
+
+static void WaitReady(void)
+{
+    struct timespec pause = {0, 10000};
+
+    while(!WDIsReady())
+    {
+        nanosleep(&pause, NULL);
+    }
+}
+
+/* StartWD blocks until both sides are up, StopWD until both are gone */
+static void BenchSync(int argc, char** argv, size_t runs)
+{
+    double start_total = 0;
+    double stop_total = 0;
+    double start = 0;
+    size_t i = 0;
+
+    for(; i < runs; ++i)
+    {
+        start = NowSec();
+        if(WD_SUCCESS != StartWD(THRESHOLD, INTERVAL, argc, argv))
+        {
+            printf("StartWD failed\n");
+            return;
+        }
+        start_total += NowSec() - start;
+
+        start = NowSec();
+        StopWD();
+        stop_total += NowSec() - start;
+    }
+
+    Report("StartWD", start_total, runs);
+    Report("StopWD", stop_total, runs);
+}
+
+static void BenchAsync(int argc, char** argv, size_t runs)
+{
+    double return_total = 0;
+    double ready_total = 0;
+    double start = 0;
+    size_t i = 0;
+
+    for(; i < runs; ++i)
+    {
+        start = NowSec();
+        if(WD_SUCCESS != StartWDAsync(THRESHOLD, INTERVAL, argc, argv, NULL,
+                                                                        NULL))
+        {
+            printf("StartWDAsync failed\n");
+            return;
+        }
+        return_total += NowSec() - start;
+
+        WaitReady();
+        ready_total += NowSec() - start;
+
+        StopWD();
+    }
+
+    Report("StartWDAsync return", return_total, runs);
+    Report("StartWDAsync ready", ready_total, runs);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t runs = argc > 1 ? (size_t)atoi(argv[1]) : RUNS;
+
+    printf("%lu runs\n", runs);
+    BenchSync(argc, argv, runs);
+    BenchAsync(argc, argv, runs);
+
+    return 0;
+}
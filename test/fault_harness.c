@@ -0,0 +1,599 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>          /* printf, sprintf, sscanf, fopen, fgets */
+#include <stdlib.h>         /* atoi, getenv, setenv, unsetenv, _exit */
+#include <string.h>         /* strcmp, strlen */
+#include <unistd.h>         /* fork, execv, setpgid, write, unlink */
+#include <signal.h>         /* kill, killpg, sigaction */
+#include <errno.h>          /* errno, ESRCH, ECHILD */
+#include <fcntl.h>          /* open, O_APPEND */
+#include <time.h>           /* clock_gettime, nanosleep */
+#include <dirent.h>         /* opendir, readdir */
+#include <sched.h>          /* sched_setaffinity, cpu_set_t */
+#include <semaphore.h>      /* sem_unlink */
+#include <sys/wait.h>       /* waitpid */
+#include <sys/prctl.h>      /* prctl, PR_SET_CHILD_SUBREAPER */
+#include <sys/resource.h>   /* setrlimit, setpriority */
+
+#include "watchdog.h"
+#include "inner_watchdog.h"
+#include "wd_ctl.h"
+#include "wd_fault.h"
+
+#ifndef WD_FAULT_INJECTION
+#error "build the harness, wd.out and the library with -DWD_FAULT_INJECTION"
+#endif
+
+#define THRESHOLD (3)
+#define INTERVAL (1)
+#define GRACE (3)
+#define TRIALS (1)
+#define SETTLE_MS (3000)
+#define OBSERVE_MS (12000)
+#define DETECT_MS (30000)
+#define START_MS (10000)
+#define STOP_MS (8000)
+#define POLL_MS (20)
+#define MAX_BUSY (16)
+#define MAX_LINE (128)
+#define LOG_PATH ("/tmp/WatchDog.fault.log")
+
+typedef enum fault_kind {
+    KIND_NONE,
+    KIND_HOOKS,
+    KIND_PAUSE,
+    KIND_HANG,
+    KIND_KILL,
+    KIND_STARVE
+} fault_kind_t;
+
+typedef enum outcome {
+    TRUE_POSITIVE,
+    FALSE_NEGATIVE,
+    FALSE_POSITIVE,
+    TRUE_NEGATIVE,
+    NO_START,
+    OUTCOMES
+} outcome_t;
+
+/* @hooks is a FAULT_ENV_NAME value, its last field is filled with SETTLE_MS */
+typedef struct scenario
+{
+    const char* name;
+    int faulty;
+    fault_kind_t kind;
+    wd_fault_side_t target;
+    const char* hooks;
+    unsigned int param;
+    int log_level;
+} scenario_t;
+
+typedef struct detector
+{
+    const char* name;
+    size_t grace;
+} detector_t;
+
+typedef struct tally
+{
+    size_t outcomes[OUTCOMES];
+    double detect_total;
+    double detect_max;
+} tally_t;
+
+/* what the clients of one trial logged */
+typedef struct events
+{
+    long client;
+    long server;
+    long last_client;
+    unsigned long ready_usec;
+    unsigned long client_revived_usec;
+    unsigned long server_revived_usec;
+} events_t;
+
+static const scenario_t scenarios[] =
+{
+    {"clean",           0, KIND_NONE,   FAULT_CLIENT, NULL,           0,    1},
+    {"drop 30%",        0, KIND_HOOKS,  FAULT_BOTH,   "2:30:0:0:%u",  0,    1},
+    {"delay 500 ms",    0, KIND_HOOKS,  FAULT_BOTH,   "2:0:500:0:%u", 0,    1},
+    {"pause 2 s",       0, KIND_PAUSE,  FAULT_CLIENT, NULL,           2000, 1},
+    {"pause 6 s",       0, KIND_PAUSE,  FAULT_CLIENT, NULL,           6000, 1},
+    {"starve x8",       0, KIND_STARVE, FAULT_CLIENT, NULL,           8,    1},
+    {"slow log 200 ms", 0, KIND_HOOKS,  FAULT_BOTH,   "2:0:0:200:%u", 0,    2},
+    {"kill client",     1, KIND_KILL,   FAULT_CLIENT, NULL,           0,    1},
+    {"kill server",     1, KIND_KILL,   FAULT_SERVER, NULL,           0,    1},
+    {"hang client",     1, KIND_HANG,   FAULT_CLIENT, NULL,           0,    1},
+    {"silent client",   1, KIND_HOOKS,  FAULT_CLIENT, "0:100:0:0:%u", 0,    1},
+    {"lossy client",    1, KIND_HOOKS,  FAULT_CLIENT, "0:80:0:0:%u",  0,    1}
+};
+
+static const detector_t detectors[] =
+{
+    {"threshold", 0},
+    {"graced", GRACE}
+};
+
+static const char* const transports[] = {"sigusr", "rtsig"};
+static const char* const outcome_names[] = {"TP", "FN", "FP", "TN", "--"};
+
+static volatile sig_atomic_t stop_requested;
+
+/*****************************Helper Functions*********************************/
+
+static unsigned long NowUsec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void SleepMsec(unsigned long msec)
+{
+    struct timespec delay;
+
+    delay.tv_sec = msec / 1000;
+    delay.tv_nsec = (long)(msec % 1000) * 1000000;
+
+    while(-1 == nanosleep(&delay, &delay) && EINTR == errno)
+    {
+    }
+}
+
+/* one append per line, every client of a trial writes to the same log */
+static void LogEvent(const char* path, const char* event, long pid, long peer)
+{
+    char line[MAX_LINE];
+    int log = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+
+    if(-1 == log)
+    {
+        return;
+    }
+
+    sprintf(line, "%s %ld %ld %lu\n", event, pid, peer, NowUsec());
+    write(log, line, strlen(line));
+    close(log);
+}
+
+/* collects the zombies of the clients, servers and busy loops we adopted */
+static void Reap(void)
+{
+    while(0 < waitpid(-1, NULL, WNOHANG))
+    {
+    }
+}
+
+static void ReadEvents(events_t* events)
+{
+    FILE* log = fopen(LOG_PATH, "r");
+    char line[MAX_LINE];
+    char event[MAX_LINE];
+    long pid = 0;
+    long peer = 0;
+    unsigned long usec = 0;
+    size_t execs = 0;
+
+    events->client = 0;
+    events->client_revived_usec = 0;
+    events->server_revived_usec = 0;
+
+    while(log && fgets(line, sizeof(line), log))
+    {
+        if(4 != sscanf(line, "%s %ld %ld %lu", event, &pid, &peer, &usec))
+        {
+            continue;
+        }
+
+        if(0 == strcmp(event, "exec"))
+        {
+            events->last_client = pid;
+            if(++execs == 2)
+            {
+                events->client_revived_usec = usec;
+            }
+        }
+        else if(0 == strcmp(event, "ready") && 0 == events->client)
+        {
+            events->client = pid;
+            events->server = peer;
+            events->ready_usec = usec;
+        }
+        else if(0 == strcmp(event, "server") &&
+                                        0 == events->server_revived_usec)
+        {
+            events->server_revived_usec = usec;
+        }
+    }
+
+    if(log)
+    {
+        fclose(log);
+    }
+}
+
+/******************************Fault Injection*********************************/
+
+/* every thread of @pid, the watchdog thread included, shares one cpu */
+static void PinThreads(pid_t pid, int cpu)
+{
+    char path[MAX_LINE];
+    struct dirent* entry = NULL;
+    cpu_set_t set;
+    DIR* tasks = NULL;
+    pid_t tid = 0;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    sprintf(path, "/proc/%ld/task", (long)pid);
+    tasks = opendir(path);
+
+    while(tasks && (entry = readdir(tasks)))
+    {
+        tid = (pid_t)atoi(entry->d_name);
+        if(tid > 0)
+        {
+            sched_setaffinity(tid, sizeof(set), &set);
+            setpriority(PRIO_PROCESS, (id_t)tid, 19);
+        }
+    }
+
+    if(tasks)
+    {
+        closedir(tasks);
+    }
+}
+
+/* @pid runs at nice 19 on one cpu with @count busy loops at nice 0 */
+static size_t Starve(pid_t pid, size_t count, pid_t* busy)
+{
+    int cpu = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    cpu_set_t set;
+    size_t i = 0;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    PinThreads(pid, cpu);
+
+    for(; i < count && i < MAX_BUSY; ++i)
+    {
+        busy[i] = fork();
+        if(0 == busy[i])
+        {
+            sched_setaffinity(0, sizeof(set), &set);
+            for(;;)
+            {
+            }
+        }
+    }
+
+    return i;
+}
+
+static void Inject(const scenario_t* scenario, pid_t target, pid_t* busy,
+                                                            size_t* busy_count)
+{
+    switch(scenario->kind)
+    {
+        case KIND_PAUSE:
+            kill(target, SIGSTOP);
+            SleepMsec(scenario->param);
+            kill(target, SIGCONT);
+            break;
+
+        case KIND_HANG:
+            kill(target, SIGSTOP);
+            break;
+
+        case KIND_KILL:
+            kill(target, SIGKILL);
+            break;
+
+        case KIND_STARVE:
+            *busy_count = Starve(target, scenario->param, busy);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************Trials***************************************/
+
+/*
+*   The latest client stops the watchdog the usual way. Whatever is left of
+*   the process group after that, a hung side or one still starting, is
+*   killed and the names it held are cleaned up
+*/
+static void TearDown(pid_t group, pid_t* busy, size_t busy_count)
+{
+    events_t events = {0};
+    unsigned long deadline = NowUsec() + STOP_MS * 1000UL;
+    size_t i = 0;
+
+    for(; i < busy_count; ++i)
+    {
+        kill(busy[i], SIGKILL);
+    }
+
+    killpg(group, SIGCONT);
+    ReadEvents(&events);
+    if(events.last_client)
+    {
+        kill((pid_t)events.last_client, SIGTERM);
+    }
+
+    while(0 == killpg(group, 0) && NowUsec() < deadline)
+    {
+        Reap();
+        SleepMsec(POLL_MS);
+    }
+
+    killpg(group, SIGKILL);
+    while(0 < waitpid(-1, NULL, 0))
+    {
+    }
+
+    sem_unlink(SEM_NAME);
+    unlink(CTL_PATH);
+    unlink(SNAPSHOT_PATH_CLIENT);
+    unlink(SNAPSHOT_PATH_SERVER);
+    unlink(LOG_PATH);
+}
+
+static void Configure(const detector_t* detector, const scenario_t* scenario)
+{
+    char request[MAX_LINE];
+    char reply[CTL_MAX_REPLY];
+
+    sprintf(request, "set grace %lu", (unsigned long)detector->grace);
+    CtlRequest(CTL_PATH, request, reply, sizeof(reply));
+    sprintf(request, "set log %d", scenario->log_level);
+    CtlRequest(CTL_PATH, request, reply, sizeof(reply));
+}
+
+static pid_t Launch(const char* self, int transport,
+                                                const scenario_t* scenario)
+{
+    char fault[MAX_LINE];
+    char transport_arg[MAX_LINE];
+    char* argv[5];
+    pid_t pid = 0;
+
+    unlink(LOG_PATH);
+    if(scenario->hooks)
+    {
+        sprintf(fault, scenario->hooks, SETTLE_MS);
+        setenv(FAULT_ENV_NAME, fault, 1);
+    }
+    else
+    {
+        unsetenv(FAULT_ENV_NAME);
+    }
+
+    sprintf(transport_arg, "%d", transport);
+    argv[0] = (char*)self;
+    argv[1] = "client";
+    argv[2] = LOG_PATH;
+    argv[3] = transport_arg;
+    argv[4] = NULL;
+
+    pid = fork();
+    if(0 == pid)
+    {
+        setpgid(0, 0);
+        execv(self, argv);
+        _exit(127);
+    }
+    setpgid(pid, pid);
+
+    return pid;
+}
+
+static outcome_t RunTrial(const char* self, const detector_t* detector,
+                            int transport, const scenario_t* scenario,
+                            double* detect_sec)
+{
+    events_t events = {0};
+    pid_t busy[MAX_BUSY];
+    size_t busy_count = 0;
+    pid_t group = Launch(self, transport, scenario);
+    unsigned long deadline = NowUsec() + START_MS * 1000UL;
+    unsigned long start = 0;
+    unsigned long detected = 0;
+    unsigned long settled = 0;
+
+    while(0 == events.client && NowUsec() < deadline)
+    {
+        SleepMsec(POLL_MS);
+        ReadEvents(&events);
+    }
+
+    if(0 == events.client)
+    {
+        TearDown(group, busy, busy_count);
+        return NO_START;
+    }
+
+    /* the hooks of the scenario start SETTLE_MS after the sides did */
+    Configure(detector, scenario);
+    settled = events.ready_usec + SETTLE_MS * 1000UL;
+    if(NowUsec() < settled)
+    {
+        SleepMsec((settled - NowUsec()) / 1000);
+    }
+
+    start = NowUsec();
+    Inject(scenario, (pid_t)(FAULT_SERVER == scenario->target ?
+                            events.server : events.client), busy, &busy_count);
+    deadline = start + (scenario->faulty ? DETECT_MS : OBSERVE_MS) * 1000UL;
+
+    while(0 == detected && NowUsec() < deadline)
+    {
+        Reap();
+        SleepMsec(POLL_MS);
+        ReadEvents(&events);
+
+        if(!scenario->faulty || FAULT_CLIENT == scenario->target)
+        {
+            detected = events.client_revived_usec;
+        }
+        if(!detected && (!scenario->faulty ||
+                                        FAULT_SERVER == scenario->target))
+        {
+            detected = events.server_revived_usec;
+        }
+    }
+
+    TearDown(group, busy, busy_count);
+    *detect_sec = detected > start ? (detected - start) / 1e6 : 0;
+
+    if(scenario->faulty)
+    {
+        return detected ? TRUE_POSITIVE : FALSE_NEGATIVE;
+    }
+
+    return detected ? FALSE_POSITIVE : TRUE_NEGATIVE;
+}
+
+/********************************Client Mode***********************************/
+
+static void StopHandler(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/* logs when it starts, when the watchdog is up and every server revival */
+static int RunClient(int argc, char* argv[])
+{
+    struct sigaction action = {0};
+    wd_metrics_t metrics = {0};
+    size_t server_restarts = 0;
+    const char* log = argv[2];
+
+    action.sa_handler = StopHandler;
+    sigaction(SIGTERM, &action, NULL);
+
+    LogEvent(log, "exec", (long)getpid(), 0);
+    WDSetTransport((wd_transport_t)atoi(argv[3]));
+
+    if(WD_SUCCESS != StartWD(THRESHOLD, INTERVAL, argc, argv))
+    {
+        return 1;
+    }
+
+    LogEvent(log, "ready", (long)getpid(), atol(getenv(ENV_VAR_NAME)));
+
+    while(!stop_requested)
+    {
+        SleepMsec(POLL_MS);
+        WDGetMetrics(&metrics);
+
+        if(metrics.server_restarts != server_restarts)
+        {
+            server_restarts = metrics.server_restarts;
+            LogEvent(log, "server", (long)getpid(), (long)server_restarts);
+        }
+    }
+
+    StopWD();
+
+    return 0;
+}
+
+/*********************************Main*****************************************/
+
+static void Report(const tally_t* tally, const detector_t* detector,
+                                                        const char* transport)
+{
+    size_t positives = tally->outcomes[TRUE_POSITIVE];
+
+    printf("%-10s %-7s %4lu %4lu %4lu %4lu %4lu", detector->name, transport,
+                        (unsigned long)tally->outcomes[TRUE_POSITIVE],
+                        (unsigned long)tally->outcomes[FALSE_NEGATIVE],
+                        (unsigned long)tally->outcomes[FALSE_POSITIVE],
+                        (unsigned long)tally->outcomes[TRUE_NEGATIVE],
+                        (unsigned long)tally->outcomes[NO_START]);
+    if(positives)
+    {
+        printf("   %6.2f s %6.2f s", tally->detect_total / positives,
+                                                        tally->detect_max);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+    const size_t detector_count = sizeof(detectors) / sizeof(detectors[0]);
+    tally_t tallies[sizeof(detectors) / sizeof(detectors[0])][2];
+    struct rlimit no_core = {0, 0};
+    size_t trials = TRIALS;
+    outcome_t outcome = NO_START;
+    double detect_sec = 0;
+    size_t d = 0;
+    size_t s = 0;
+    size_t i = 0;
+    int t = 0;
+
+    if(argc > 1 && 0 == strcmp(argv[1], "client"))
+    {
+        return argc < 4 ? 2 : RunClient(argc, argv);
+    }
+
+    trials = argc > 1 ? (size_t)atoi(argv[1]) : TRIALS;
+
+    /* revived sides are orphans, adopt them to reap them and kill them */
+    prctl(PR_SET_CHILD_SUBREAPER, 1);
+    setrlimit(RLIMIT_CORE, &no_core);
+    memset(tallies, 0, sizeof(tallies));
+
+    for(d = 0; d < detector_count; ++d)
+    {
+        for(t = 0; t < 2; ++t)
+        {
+            printf("%s, %s\n", detectors[d].name, transports[t]);
+            for(s = 0; s < scenario_count; ++s)
+            {
+                for(i = 0; i < trials; ++i)
+                {
+                    outcome = RunTrial(argv[0], detectors + d, t,
+                                            scenarios + s, &detect_sec);
+                    ++tallies[d][t].outcomes[outcome];
+                    if(TRUE_POSITIVE == outcome)
+                    {
+                        tallies[d][t].detect_total += detect_sec;
+                        if(detect_sec > tallies[d][t].detect_max)
+                        {
+                            tallies[d][t].detect_max = detect_sec;
+                        }
+                    }
+                    printf("  %-16s %s", scenarios[s].name,
+                                                outcome_names[outcome]);
+                    if(FALSE_POSITIVE == outcome || TRUE_POSITIVE == outcome)
+                    {
+                        printf(" after %.2f s", detect_sec);
+                    }
+                    printf("\n");
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    printf("\ndetector   transport  TP   FN   FP   TN  n/a"
+                                "   detect mean    max\n");
+    for(d = 0; d < detector_count; ++d)
+    {
+        for(t = 0; t < 2; ++t)
+        {
+            Report(&tallies[d][t], detectors + d, transports[t]);
+        }
+    }
+
+    return 0;
+}
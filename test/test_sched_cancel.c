@@ -0,0 +1,80 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>      /* printf */
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <time.h>       /* nanosleep */
+
+#include "heap_scheduler.h"
+
+#define VICTIM_SEC (2)
+#define STOP_SEC (3)
+
+typedef struct cancel_test
+{
+    scheduler_t* scheduler;
+    sched_handle_t victim;
+    int cancel_result;
+    int runs;
+} cancel_test_t;
+
+static int Victim(void* params)
+{
+    ++((cancel_test_t*)params)->runs;
+
+    return 0;
+}
+
+static int Stop(void* params)
+{
+    SchedulerStop(((cancel_test_t*)params)->scheduler);
+
+    return 1;
+}
+
+/* cancels the victim while the loop waits for it to be due */
+static void* Canceller(void* params)
+{
+    cancel_test_t* test = params;
+    struct timespec wait = {0, 500000000};
+
+    nanosleep(&wait, NULL);
+    test->cancel_result = SchedulerCancel(test->scheduler, test->victim);
+
+    return NULL;
+}
+
+int main(void)
+{
+    cancel_test_t test = {0};
+    pthread_t canceller;
+    int failed = 0;
+
+    test.scheduler = SchedulerCreate();
+    if (!test.scheduler)
+    {
+        printf("SchedulerCreate failed\n");
+        return 1;
+    }
+
+    SchedulerAddEx(test.scheduler, Victim, &test, VICTIM_SEC, SCHED_NORMAL,
+                                                    NULL, &test.victim);
+    SchedulerAdd(test.scheduler, Stop, &test, STOP_SEC);
+
+    if (pthread_create(&canceller, NULL, Canceller, &test) != 0)
+    {
+        printf("pthread_create failed\n");
+        SchedulerDestroy(test.scheduler);
+        return 1;
+    }
+
+    SchedulerRun(test.scheduler);
+    pthread_join(canceller, NULL);
+
+    failed = test.cancel_result != 0 || test.runs != 0;
+    printf("cancel during the wait: %s (cancel %d, runs %d)\n",
+            failed ? "FAILED" : "passed", test.cancel_result, test.runs);
+
+    SchedulerDestroy(test.scheduler);
+
+    return failed;
+}
@@ -11,8 +11,20 @@ int main(int argc, char* argv[])
 {
     FILE* fd = fopen("MrMeeseeks.txt", "a");
     size_t i = 0;
+    int slot = 0;
     
     StartWD(THRESHOLD, INTERVAL, argc, argv);
+    slot = WDRegisterThread();
+
+    if(-1 == slot)
+    {
+        fprintf(stderr, "No free watchdog thread slot\n");
+        fclose(fd);
+        StopWD();
+
+        return 1;
+    }
+
     printf("Running now\n");
 
     fprintf(fd, "Hi, Im Mr Meeseeks!!\n");
@@ -22,9 +34,12 @@ int main(int argc, char* argv[])
         if(i % 100000 == 0)
         {
             fprintf(fd, "Hi Mr Meeseeks, Im Mr Meeseeks!!\n");
+            WDKick(slot);
         }   
     }
 
+    WDUnregisterThread(slot);
+
     fprintf(fd, "Kill Jerry!!!!\n");
 
     fclose(fd);